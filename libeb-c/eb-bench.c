@@ -0,0 +1,269 @@
+// Benchmark harness for the libeb-c hot paths.
+//
+// Spawns a loopback Etherbone responder on 127.0.0.1 and drives the
+// single-word, block, scatter-gather and pipelined APIs against it,
+// reporting ops/sec plus p50/p99 latency so regressions in the packet
+// fill/parse and socket paths are measurable.  Run with no arguments to
+// benchmark both TCP and UDP (direct) modes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "etherbone.h"
+
+#define BENCH_OPS   10000
+#define BENCH_WORDS 16384
+
+struct responder {
+    int is_direct;
+    int listen_fd;
+    uint16_t port;
+    pthread_t thread;
+};
+
+// Build a reply for one request packet.  Reads are answered with the
+// requested address as the value; writes produce no reply.  Returns the
+// reply length, or 0 if no reply is due.
+static size_t respond(const uint8_t *req, uint8_t *resp) {
+    unsigned int rcount = req[11];
+    unsigned int i;
+    uint32_t word;
+
+    if (rcount == 0)
+        return 0;
+
+    eb_fill_header(resp);
+    resp[8] = 0;
+    resp[9] = 0x0f;
+    resp[10] = rcount;		// Reads come back as write records
+    resp[11] = 0;
+    memset(&resp[12], 0, 4);	// Base return address
+
+    for (i = 0; i < rcount; i++) {
+        memcpy(&word, &req[16 + i * 4], sizeof(word));
+        memcpy(&resp[16 + i * 4], &word, sizeof(word));
+    }
+    return 16 + rcount * 4;
+}
+
+static size_t packet_length(const uint8_t *pkt) {
+    unsigned int count = pkt[10] > pkt[11] ? pkt[10] : pkt[11];
+    return 16 + count * 4;
+}
+
+static void *udp_responder(void *arg) {
+    struct responder *resp = arg;
+    uint8_t req[EB_HEADER_LENGTH + EB_RECORD_HEADER_LENGTH + EB_MAX_RECORD_COUNT * 4];
+    uint8_t reply[sizeof(req)];
+    struct sockaddr_in peer;
+
+    // Replies go to the client's wildcard-bound Rx socket, which
+    // listens on the same port number as the responder (the LiteX
+    // Etherbone convention).
+    memset(&peer, 0, sizeof(peer));
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    peer.sin_port = htons(resp->port);
+
+    while (1) {
+        int len = recvfrom(resp->listen_fd, req, sizeof(req), 0, NULL, NULL);
+        if (len < 16)
+            break;
+
+        size_t reply_len = respond(req, reply);
+        if (reply_len)
+            sendto(resp->listen_fd, reply, reply_len, 0, (struct sockaddr *)&peer, sizeof(peer));
+    }
+    return NULL;
+}
+
+static int recv_full(int fd, uint8_t *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        int ret = read(fd, buf + got, len - got);
+        if (ret <= 0)
+            return -1;
+        got += ret;
+    }
+    return 0;
+}
+
+static void *tcp_responder(void *arg) {
+    struct responder *resp = arg;
+    uint8_t req[EB_HEADER_LENGTH + EB_RECORD_HEADER_LENGTH + EB_MAX_RECORD_COUNT * 4];
+    uint8_t reply[sizeof(req)];
+    int val = 1;
+
+    int fd = accept(resp->listen_fd, NULL, NULL);
+    if (fd == -1)
+        return NULL;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+
+    while (1) {
+        // Header plus record header first, then the operation words
+        if (recv_full(fd, req, 16))
+            break;
+        size_t len = packet_length(req);
+        if (len > 16 && recv_full(fd, &req[16], len - 16))
+            break;
+
+        size_t reply_len = respond(req, reply);
+        if (reply_len && write(fd, reply, reply_len) != (int)reply_len)
+            break;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int responder_start(struct responder *resp, int is_direct) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+
+    // In UDP mode the client binds its Rx socket to the responder's
+    // port on the wildcard address, so the responder lives on a second
+    // loopback address and both sides set SO_REUSEADDR.
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(is_direct ? INADDR_LOOPBACK + 1 : INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    resp->is_direct = is_direct;
+    resp->listen_fd = socket(AF_INET, is_direct ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (resp->listen_fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    setsockopt(resp->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(resp->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("bind");
+        return -1;
+    }
+    if (getsockname(resp->listen_fd, (struct sockaddr *)&addr, &addr_len) == -1) {
+        perror("getsockname");
+        return -1;
+    }
+    resp->port = ntohs(addr.sin_port);
+
+    if (!is_direct && listen(resp->listen_fd, 1) == -1) {
+        perror("listen");
+        return -1;
+    }
+
+    return pthread_create(&resp->thread, NULL, is_direct ? udp_responder : tcp_responder, resp);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static void report(const char *name, unsigned int ops, double elapsed_us, double *lat, unsigned int nlat) {
+    printf("  %-16s %10.0f ops/sec", name, ops / (elapsed_us / 1e6));
+    if (nlat) {
+        qsort(lat, nlat, sizeof(*lat), cmp_double);
+        printf("   p50 %7.2f us   p99 %7.2f us", lat[nlat / 2], lat[(unsigned int)(nlat * 0.99)]);
+    }
+    printf("\n");
+}
+
+static void async_cb(uint32_t addr, uint32_t value, void *user) {
+    unsigned int *errors = user;
+    if (value != addr)
+        (*errors)++;
+}
+
+static int run_bench(int is_direct) {
+    struct responder resp;
+    struct eb_connection *conn;
+    char port[16];
+    static double lat[BENCH_OPS];
+    static uint32_t words[BENCH_WORDS];
+    static uint32_t addrs[BENCH_OPS];
+    unsigned int i;
+    unsigned int errors = 0;
+    double start;
+
+    if (responder_start(&resp, is_direct))
+        return 1;
+
+    snprintf(port, sizeof(port), "%u", resp.port);
+    conn = eb_connect(is_direct ? "127.0.0.2" : "127.0.0.1", port, is_direct);
+    if (!conn) {
+        fprintf(stderr, "unable to connect to loopback responder\n");
+        return 1;
+    }
+
+    printf("%s mode:\n", is_direct ? "UDP" : "TCP");
+
+    // Single-word writes (no reply expected, so no latency column)
+    start = now_us();
+    for (i = 0; i < BENCH_OPS; i++)
+        eb_write32(conn, i, 0x40000000 + i * 4);
+    report("eb_write32", BENCH_OPS, now_us() - start, NULL, 0);
+
+    // Single-word stop-and-wait reads
+    start = now_us();
+    for (i = 0; i < BENCH_OPS; i++) {
+        double op_start = now_us();
+        if (eb_read32(conn, 0x40000000 + i * 4) != 0x40000000 + i * 4)
+            errors++;
+        lat[i] = now_us() - op_start;
+    }
+    report("eb_read32", BENCH_OPS, now_us() - start, lat, BENCH_OPS);
+
+    // Pipelined reads
+    start = now_us();
+    for (i = 0; i < BENCH_OPS; i++)
+        eb_read32_async(conn, 0x40000000 + i * 4, async_cb, &errors);
+    eb_flush_reads(conn);
+    report("eb_read32_async", BENCH_OPS, now_us() - start, NULL, 0);
+
+    // Contiguous block transfers
+    start = now_us();
+    if (eb_read_block(conn, 0x40000000, words, BENCH_WORDS))
+        errors++;
+    report("eb_read_block", BENCH_WORDS, now_us() - start, NULL, 0);
+
+    start = now_us();
+    if (eb_write_block(conn, 0x40000000, words, BENCH_WORDS))
+        errors++;
+    report("eb_write_block", BENCH_WORDS, now_us() - start, NULL, 0);
+
+    // Scattered reads
+    for (i = 0; i < BENCH_OPS; i++)
+        addrs[i] = 0x40000000 + (i * 257 % BENCH_WORDS) * 4;
+    start = now_us();
+    if (eb_readv(conn, addrs, words, BENCH_OPS))
+        errors++;
+    report("eb_readv", BENCH_OPS, now_us() - start, NULL, 0);
+
+    if (errors)
+        fprintf(stderr, "%u readback mismatches\n", errors);
+
+    eb_disconnect(&conn);
+    close(resp.listen_fd);
+    pthread_cancel(resp.thread);
+    pthread_join(resp.thread, NULL);
+    return errors != 0;
+}
+
+int main(void) {
+    int ret = run_bench(0);
+    ret |= run_bench(1);
+    return ret;
+}
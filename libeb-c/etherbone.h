@@ -5,6 +5,7 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stddef.h>
 #include <stdint.h>
 
 /*
@@ -51,23 +52,80 @@ struct etherbone_packet {
 	struct etherbone_record records[0];
 } __attribute__((packed));
 
-LiteX only supports a single record per packet, so either wcount or rcount
-is set to 1.  For a read, the read_addr is specified.  For a write, the
-write_addr is specified along with a value.
+For the simple single-word helpers, either wcount or rcount is set to 1.
+For a read, the read_addr is specified.  For a write, the write_addr is
+specified along with a value.
 
-The same type of record is returned, so your data is at offset 16.
+A record may also carry up to 255 operations.  For writes, write_addr is
+the base address and is followed by wcount values that land at
+incrementing addresses.  For reads, the first word is the base return
+address, followed by rcount (arbitrary, non-incrementing) addresses to
+read.  The reply mirrors the record, so returned data always starts at
+offset 16.
 */
 
+/* Fixed sizes of the pieces that make up an Etherbone packet */
+#define EB_HEADER_LENGTH        8
+#define EB_RECORD_HEADER_LENGTH 8   /* record flags/counts plus base address */
+#define EB_MAX_RECORD_COUNT     255 /* wcount and rcount are one byte each */
+
+/* Limits on the number of pipelined reads kept in flight */
+#define EB_MAX_READ_WINDOW      64
+#define EB_DEFAULT_READ_WINDOW  32
+
+/* Number of warm connections an eb_pool keeps open */
+#define EB_POOL_SIZE            64
+
 struct eb_connection;
+struct eb_pool;
+
+/* Optional socket tuning applied at connect time by eb_connect_opts().
+ * Fields left at zero keep the kernel defaults.  These knobs trade
+ * host CPU for tail latency: busy_poll_us asks the kernel to poll the
+ * NIC instead of sleeping (SO_BUSY_POLL, Linux only, may require
+ * privileges), rcvbuf/sndbuf size the socket buffers, and spin_us makes
+ * eb_recv() spin on nonblocking receives for that long before falling
+ * back to a blocking read, skipping the scheduler wakeup when the reply
+ * is already in flight. */
+struct eb_options {
+    unsigned int busy_poll_us;  /* SO_BUSY_POLL duration in microseconds */
+    unsigned int rcvbuf;        /* SO_RCVBUF size in bytes */
+    unsigned int sndbuf;        /* SO_SNDBUF size in bytes */
+    unsigned int spin_us;       /* receive spin time in microseconds */
+};
+
+typedef void (*eb_read_callback)(uint32_t addr, uint32_t value, void *user);
 
 int eb_unfill_read32(uint8_t wb_buffer[20]);
 int eb_fill_write32(uint8_t wb_buffer[20], uint32_t data, uint32_t address);
 int eb_fill_read32(uint8_t wb_buffer[20], uint32_t address);
 
+int eb_fill_header(uint8_t wb_buffer[EB_HEADER_LENGTH]);
+int eb_fill_write_record(uint8_t *wb_buffer, uint32_t base_address, const uint32_t *values, unsigned int count);
+int eb_fill_read_record(uint8_t *wb_buffer, const uint32_t *addresses, unsigned int count);
+int eb_unfill_values(const uint8_t *wb_buffer, uint32_t *values, unsigned int count);
+
 struct eb_connection *eb_connect(const char *addr, const char *port, int is_direct);
+struct eb_connection *eb_connect_timeout(const char *addr, const char *port, int is_direct, unsigned int timeout_ms);
+struct eb_connection *eb_connect_opts(const char *addr, const char *port, int is_direct, unsigned int timeout_ms, const struct eb_options *options);
 void eb_disconnect(struct eb_connection **conn);
+
+struct eb_pool *eb_pool_new(void);
+struct eb_connection *eb_pool_get(struct eb_pool *pool, const char *addr, const char *port, int is_direct, unsigned int timeout_ms);
+void eb_pool_free(struct eb_pool **pool);
 uint32_t eb_read32(struct eb_connection *conn, uint32_t addr);
 void eb_write32(struct eb_connection *conn, uint32_t val, uint32_t addr);
+int eb_negotiate(struct eb_connection *conn, unsigned int timeout_ms);
+uint64_t eb_read64(struct eb_connection *conn, uint32_t addr);
+void eb_write64(struct eb_connection *conn, uint64_t val, uint32_t addr);
+int eb_read_block(struct eb_connection *conn, uint32_t addr, uint32_t *data, size_t count);
+int eb_write_block(struct eb_connection *conn, uint32_t addr, const uint32_t *data, size_t count);
+int eb_readv(struct eb_connection *conn, const uint32_t *addrs, uint32_t *values, size_t count);
+int eb_set_read_window(struct eb_connection *conn, unsigned int window);
+void eb_lock(struct eb_connection *conn);
+void eb_unlock(struct eb_connection *conn);
+int eb_read32_async(struct eb_connection *conn, uint32_t addr, eb_read_callback callback, void *user);
+int eb_flush_reads(struct eb_connection *conn);
 
 #ifdef __cplusplus
 };
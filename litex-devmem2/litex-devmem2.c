@@ -2,12 +2,22 @@
 #include <stdlib.h>
 #include <getopt.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "etherbone.h"
 
 static void print_help(const char *progname) {
     printf("Usage: %s [-t|--target target] [-p|--port port]\n"
            "                  [-a|--address address] [-v|--value value]\n"
+           "                  [-c|--count count]\n"
+           "                  [-l|--load file] [-s|--save file]\n"
+           "                  [-b|--batch file]\n"
+           "                  [-i|--poll interval-ms] [-o|--on-change]\n"
+           "                  [-f|--fill value]\n"
+           "                  [-B|--bench seconds]\n"
+           "                  [-T|--targets file]\n"
            "                  [-w|--write-only]\n"
            "                  [-q|--quiet]\n"
            "                  [-d|--direct]\n", progname);
@@ -16,10 +26,446 @@ static void print_help(const char *progname) {
     printf("To connect directly over Etherbone without using litex_server, use --direct.\n");
     printf("If --value is omitted, then a read is performed.  Otherwise, a write is performed.\n");
     printf("If --write-only is specified, then no readback is performed.\n");
+    printf("If --count is specified, a contiguous range of words is read using block\n");
+    printf("transfers and printed as a hexdump.\n");
+    printf("--bench hammers the address with write+readback round trips for the\n");
+    printf("given duration and reports rate and latency percentiles.\n");
+    printf("--fill writes --count copies of a value starting at the address using\n");
+    printf("packed write records, then spot-checks the result.\n");
+    printf("--poll re-reads the address at the given interval over one connection;\n");
+    printf("with --on-change only value transitions are printed.\n");
+    printf("--batch executes read/write commands from a file (or - for stdin) over\n");
+    printf("a single persistent connection.\n");
+    printf("--load streams a binary file into memory at the given address; --save\n");
+    printf("streams --count words out to a file.  Words are big-endian on the wire\n");
+    printf("and in the file.\n");
+    printf("--targets runs the same read/write or --batch script against every\n");
+    printf("host listed in a file (one host[:port] per line) concurrently, one\n");
+    printf("connection per host, and prints the results per target.\n");
 
     return;
 }
 
+// Dump a range of words as a hexdump, using block transfers so the
+// whole range costs a handful of packets instead of one per word.
+static int dump_range(struct eb_connection *conn, uint32_t address, size_t count, FILE *out) {
+    uint32_t words[4096];
+
+    while (count > 0) {
+        size_t chunk = count > sizeof(words) / sizeof(words[0]) ? sizeof(words) / sizeof(words[0]) : count;
+        size_t i;
+
+        if (eb_read_block(conn, address, words, chunk)) {
+            fprintf(out, "block read failed at 0x%08x\n", address);
+            return 1;
+        }
+
+        for (i = 0; i < chunk; i++) {
+            if ((i % 4) == 0)
+                fprintf(out, "0x%08x:", (uint32_t)(address + i * 4));
+            fprintf(out, " 0x%08x", words[i]);
+            if ((i % 4) == 3 || i == chunk - 1)
+                fprintf(out, "\n");
+        }
+
+        address += chunk * 4;
+        count -= chunk;
+    }
+    return 0;
+}
+
+// Execute read/write commands line-by-line over one persistent
+// connection.  Commands are:
+//   read ADDR [COUNT]
+//   write ADDR VALUE
+// Results go to out, which stays block-buffered for the whole run.
+static int run_batch(struct eb_connection *conn, FILE *script, FILE *out) {
+    char line[256];
+    int errors = 0;
+
+    while (fgets(line, sizeof(line), script)) {
+        char cmd[16];
+        unsigned long addr, arg;
+        int n = sscanf(line, "%15s %li %li", cmd, &addr, &arg);
+
+        if (n <= 0 || cmd[0] == '#')
+            continue;
+
+        if (!strcmp(cmd, "read") && n >= 2) {
+            if (n == 3 && arg > 1) {
+                if (dump_range(conn, addr, arg, out))
+                    errors++;
+            } else {
+                fprintf(out, "0x%08lx: 0x%08x\n", addr, eb_read32(conn, addr));
+            }
+        } else if (!strcmp(cmd, "write") && n == 3) {
+            eb_write32(conn, arg, addr);
+            fprintf(out, "0x%08lx -> 0x%08lx\n", addr, arg);
+        } else {
+            fprintf(out, "unrecognized command: %s", line);
+            errors++;
+        }
+    }
+
+    fflush(out);
+    return errors != 0;
+}
+
+// One entry per line of the --targets file.  Each worker owns its
+// connection and writes results to a memory stream, so output from
+// different boards never interleaves.
+struct fanout_target {
+    char host[128];
+    char port[16];
+    int direct;
+    uint32_t address;
+    int have_value;
+    uint32_t value;
+    int write_only;
+    const char *batch_text;     /* NULL for the single read/write op */
+    char *out_buf;
+    size_t out_len;
+    int ret;
+    pthread_t thread;
+};
+
+static void *fanout_worker(void *arg) {
+    struct fanout_target *t = arg;
+    FILE *out = open_memstream(&t->out_buf, &t->out_len);
+    struct eb_connection *conn;
+
+    if (!out) {
+        t->ret = 1;
+        return NULL;
+    }
+
+    conn = eb_connect(t->host, t->port, t->direct);
+    if (!conn) {
+        fprintf(out, "unable to create connection\n");
+        t->ret = 1;
+        fclose(out);
+        return NULL;
+    }
+
+    if (t->batch_text) {
+        FILE *script = fmemopen((void *)t->batch_text, strlen(t->batch_text), "r");
+
+        if (!script) {
+            fprintf(out, "unable to open script\n");
+            t->ret = 1;
+        } else {
+            t->ret = run_batch(conn, script, out);
+            fclose(script);
+        }
+    } else if (t->have_value) {
+        if (t->write_only) {
+            eb_write32(conn, t->value, t->address);
+            fprintf(out, "0x%08x -> 0x%08x\n", t->address, t->value);
+        } else {
+            uint32_t old_val = eb_read32(conn, t->address);
+            eb_write32(conn, t->value, t->address);
+            uint32_t new_val = eb_read32(conn, t->address);
+            fprintf(out, "0x%08x 0x%08x -> 0x%08x (wanted: 0x%08x)\n",
+                    t->address, old_val, new_val, t->value);
+        }
+    } else {
+        fprintf(out, "0x%08x: 0x%08x\n", t->address, eb_read32(conn, t->address));
+    }
+
+    eb_disconnect(&conn);
+    fclose(out);
+    return NULL;
+}
+
+// Run the same operation against every host listed in a file, one
+// connection and one thread per target, so the wall-clock time is set
+// by the slowest board instead of the sum of all boards.  Results are
+// printed in file order once all workers have finished.
+static int run_fanout(const char *targets_path, const char *default_port, int direct,
+                      uint32_t address, int have_value, uint32_t value, int write_only,
+                      const char *batch_text) {
+    struct fanout_target *targets = NULL;
+    size_t ntargets = 0;
+    size_t capacity = 0;
+    char line[256];
+    FILE *f = fopen(targets_path, "r");
+    size_t i;
+    int errors = 0;
+
+    if (!f) {
+        perror(targets_path);
+        return 1;
+    }
+
+    // One target per line, "host" or "host:port"; '#' starts a comment.
+    while (fgets(line, sizeof(line), f)) {
+        char *host = strtok(line, " \t\r\n");
+        char *colon;
+        struct fanout_target *t;
+
+        if (!host || host[0] == '#')
+            continue;
+
+        if (ntargets == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            targets = realloc(targets, capacity * sizeof(*targets));
+            if (!targets) {
+                fprintf(stderr, "out of memory\n");
+                fclose(f);
+                return 1;
+            }
+        }
+        t = &targets[ntargets++];
+        memset(t, 0, sizeof(*t));
+
+        colon = strchr(host, ':');
+        if (colon) {
+            *colon = '\0';
+            snprintf(t->port, sizeof(t->port), "%s", colon + 1);
+        } else {
+            snprintf(t->port, sizeof(t->port), "%s", default_port);
+        }
+        snprintf(t->host, sizeof(t->host), "%s", host);
+        t->direct = direct;
+        t->address = address;
+        t->have_value = have_value;
+        t->value = value;
+        t->write_only = write_only;
+        t->batch_text = batch_text;
+    }
+    fclose(f);
+
+    if (ntargets == 0) {
+        fprintf(stderr, "%s: no targets listed\n", targets_path);
+        free(targets);
+        return 1;
+    }
+
+    for (i = 0; i < ntargets; i++) {
+        if (pthread_create(&targets[i].thread, NULL, fanout_worker, &targets[i])) {
+            fprintf(stderr, "unable to start worker for %s:%s\n",
+                    targets[i].host, targets[i].port);
+            // Mark it failed and run nothing; join below skips it
+            targets[i].thread = pthread_self();
+            targets[i].ret = 1;
+        }
+    }
+
+    for (i = 0; i < ntargets; i++) {
+        struct fanout_target *t = &targets[i];
+
+        if (!pthread_equal(t->thread, pthread_self()))
+            pthread_join(t->thread, NULL);
+        printf("%s:%s%s\n", t->host, t->port, t->ret ? " (failed)" : "");
+        if (t->out_buf) {
+            fwrite(t->out_buf, 1, t->out_len, stdout);
+            free(t->out_buf);
+        }
+        if (t->ret)
+            errors++;
+    }
+    free(targets);
+
+    if (errors)
+        fprintf(stderr, "%d of %zu targets failed\n", errors, ntargets);
+    return errors != 0;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Re-read one address at a fixed rate over the open connection.  Each
+// sample costs one packet exchange; with on_change set only transitions
+// are printed.
+static int poll_address(struct eb_connection *conn, uint32_t address, unsigned int interval_ms, int on_change) {
+    uint32_t last = 0;
+    int first = 1;
+
+    while (1) {
+        uint32_t val = eb_read32(conn, address);
+
+        if (first || !on_change || val != last) {
+            printf("%.6f 0x%08x: 0x%08x\n", now_sec(), address, val);
+            fflush(stdout);
+        }
+
+        last = val;
+        first = 0;
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Hammer a scratch register with single-word round trips for the given
+// duration and report achieved rate plus latency percentiles, as a
+// field diagnostic for host-to-board link quality.
+static int bench_link(struct eb_connection *conn, uint32_t address, unsigned int seconds) {
+    static double lat[1000000];
+    size_t ops = 0;
+    double start = now_sec();
+    double deadline = start + seconds;
+    double elapsed;
+
+    while (now_sec() < deadline && ops < sizeof(lat) / sizeof(lat[0])) {
+        double op_start = now_sec();
+
+        eb_write32(conn, ops, address);
+        if (eb_read32(conn, address) != ops) {
+            fprintf(stderr, "readback mismatch on round trip %zu\n", ops);
+            return 1;
+        }
+        lat[ops++] = now_sec() - op_start;
+    }
+    elapsed = now_sec() - start;
+
+    if (ops == 0) {
+        fprintf(stderr, "no round trips completed\n");
+        return 1;
+    }
+
+    qsort(lat, ops, sizeof(*lat), cmp_double);
+    printf("%zu round trips in %.3f seconds (%.0f/sec)\n", ops, elapsed, ops / elapsed);
+    printf("latency p50 %.1f us / p99 %.1f us / max %.1f us\n",
+           lat[ops / 2] * 1e6, lat[(size_t)(ops * 0.99)] * 1e6, lat[ops - 1] * 1e6);
+    return 0;
+}
+
+// Fill a range with one value using maximal write records (writes are
+// not individually acknowledged), then spot-check a few words.
+static int fill_range(struct eb_connection *conn, uint32_t address, uint32_t value, size_t count) {
+    uint32_t words[4096];
+    uint32_t remaining = count;
+    uint32_t fill_addr = address;
+    uint32_t check_addrs[3];
+    uint32_t check_vals[3];
+    size_t nchecks = count < 3 ? count : 3;
+    size_t i;
+    double start;
+
+    for (i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+        words[i] = value;
+
+    start = now_sec();
+    while (remaining > 0) {
+        size_t chunk = remaining > sizeof(words) / sizeof(words[0]) ? sizeof(words) / sizeof(words[0]) : remaining;
+
+        if (eb_write_block(conn, fill_addr, words, chunk)) {
+            fprintf(stderr, "block write failed at 0x%08x\n", fill_addr);
+            return 1;
+        }
+        fill_addr += chunk * 4;
+        remaining -= chunk;
+    }
+
+    // Spot-check the first, middle and last words
+    check_addrs[0] = address;
+    check_addrs[1] = address + (count / 2) * 4;
+    check_addrs[2] = address + (count - 1) * 4;
+    if (eb_readv(conn, check_addrs, check_vals, nchecks)) {
+        fprintf(stderr, "readback failed\n");
+        return 1;
+    }
+    for (i = 0; i < nchecks; i++) {
+        if (check_vals[i] != value) {
+            fprintf(stderr, "readback mismatch at 0x%08x: 0x%08x (wanted 0x%08x)\n",
+                    check_addrs[i], check_vals[i], value);
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "filled %zu words in %.3f seconds (%.1f KiB/s)\n",
+            count, now_sec() - start, count * 4 / 1024.0 / (now_sec() - start));
+    return 0;
+}
+
+// Stream a binary file into target memory using maximal write records.
+static int load_file(struct eb_connection *conn, uint32_t address, const char *path) {
+    uint32_t words[4096];
+    uint8_t bytes[sizeof(words)];
+    FILE *f = fopen(path, "rb");
+    size_t total = 0;
+    size_t len;
+    double start;
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    start = now_sec();
+    while ((len = fread(bytes, 1, sizeof(bytes), f)) > 0) {
+        size_t nwords = (len + 3) / 4;
+        size_t i;
+
+        // Pad the trailing partial word with zeroes
+        memset(&bytes[len], 0, nwords * 4 - len);
+        for (i = 0; i < nwords; i++)
+            words[i] = (uint32_t)bytes[i * 4] << 24 | (uint32_t)bytes[i * 4 + 1] << 16
+                     | (uint32_t)bytes[i * 4 + 2] << 8 | bytes[i * 4 + 3];
+
+        if (eb_write_block(conn, address, words, nwords)) {
+            fprintf(stderr, "block write failed at 0x%08x\n", address);
+            fclose(f);
+            return 1;
+        }
+
+        address += nwords * 4;
+        total += len;
+    }
+    fclose(f);
+
+    fprintf(stderr, "loaded %zu bytes in %.3f seconds (%.1f KiB/s)\n",
+            total, now_sec() - start, total / 1024.0 / (now_sec() - start));
+    return 0;
+}
+
+// Stream target memory out to a binary file using block reads.
+static int save_file(struct eb_connection *conn, uint32_t address, size_t count, const char *path) {
+    uint32_t words[4096];
+    FILE *f = fopen(path, "wb");
+    size_t total = 0;
+    double start;
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    start = now_sec();
+    while (count > 0) {
+        size_t chunk = count > sizeof(words) / sizeof(words[0]) ? sizeof(words) / sizeof(words[0]) : count;
+        size_t i;
+
+        if (eb_read_block(conn, address, words, chunk)) {
+            fprintf(stderr, "block read failed at 0x%08x\n", address);
+            fclose(f);
+            return 1;
+        }
+
+        for (i = 0; i < chunk; i++) {
+            uint8_t bytes[4] = { words[i] >> 24, words[i] >> 16, words[i] >> 8, words[i] };
+            fwrite(bytes, 1, sizeof(bytes), f);
+        }
+
+        address += chunk * 4;
+        count -= chunk;
+        total += chunk * 4;
+    }
+    fclose(f);
+
+    fprintf(stderr, "saved %zu bytes in %.3f seconds (%.1f KiB/s)\n",
+            total, now_sec() - start, total / 1024.0 / (now_sec() - start));
+    return 0;
+}
+
 int main(int argc, char **argv) {
 
     struct eb_connection *conn;
@@ -33,12 +479,31 @@ int main(int argc, char **argv) {
     int c;
     uint32_t address = 0;
     uint32_t value = 0;
+    size_t count = 0;
+    const char *load_path = NULL;
+    const char *save_path = NULL;
+    const char *batch_path = NULL;
+    const char *targets_path = NULL;
+    unsigned int poll_interval = 0;
+    int on_change = 0;
+    int have_fill = 0;
+    uint32_t fill_value = 0;
+    unsigned int bench_seconds = 0;
 
     while (1) {
         int option_index = 0;
         static struct option long_options[] = {
             {"address", required_argument, 0, 'a'},
             {"value", required_argument, 0, 'v'},
+            {"count", required_argument, 0, 'c'},
+            {"load", required_argument, 0, 'l'},
+            {"batch", required_argument, 0, 'b'},
+            {"poll", required_argument, 0, 'i'},
+            {"fill", required_argument, 0, 'f'},
+            {"bench", required_argument, 0, 'B'},
+            {"targets", required_argument, 0, 'T'},
+            {"on-change", no_argument, 0, 'o'},
+            {"save", required_argument, 0, 's'},
             {"target", required_argument, 0, 't'},
             {"port", required_argument, 0, 'p'},
             {"direct", no_argument, 0, 'd'},
@@ -48,7 +513,7 @@ int main(int argc, char **argv) {
             {0, 0, 0, 0},
         };
 
-        c = getopt_long(argc, argv, "a:v:t:p:dwqh", long_options, &option_index);
+        c = getopt_long(argc, argv, "a:v:c:l:s:b:i:of:B:T:t:p:dwqh", long_options, &option_index);
         if (c == -1)
             break;
 
@@ -72,6 +537,50 @@ int main(int argc, char **argv) {
             have_value = 1;
             break;
 
+        case 'c':
+            fprintf(stderr, "Setting count: %s\n", optarg);
+            count = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'l':
+            fprintf(stderr, "Loading file: %s\n", optarg);
+            load_path = optarg;
+            break;
+
+        case 'b':
+            batch_path = optarg;
+            break;
+
+        case 'i':
+            fprintf(stderr, "Setting poll interval: %s ms\n", optarg);
+            poll_interval = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'o':
+            on_change = 1;
+            break;
+
+        case 'f':
+            fprintf(stderr, "Setting fill value: %s\n", optarg);
+            fill_value = strtoul(optarg, NULL, 0);
+            have_fill = 1;
+            break;
+
+        case 'B':
+            fprintf(stderr, "Benchmarking for %s seconds\n", optarg);
+            bench_seconds = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'T':
+            fprintf(stderr, "Reading targets from: %s\n", optarg);
+            targets_path = optarg;
+            break;
+
+        case 's':
+            fprintf(stderr, "Saving to file: %s\n", optarg);
+            save_path = optarg;
+            break;
+
         case 'q':
             quiet = 1;
             break;
@@ -118,17 +627,121 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (!have_address) {
+    if (!have_address && !batch_path) {
         printf("%s: Must specify an address\n", argv[0]);
         return 1;
     }
 
+    if (targets_path) {
+        char *batch_text = NULL;
+        int ret;
+
+        if (poll_interval || load_path || save_path || bench_seconds || have_fill || count) {
+            fprintf(stderr, "--targets only supports single read/write and --batch operations\n");
+            return 1;
+        }
+
+        if (batch_path) {
+            // Slurp the script once so every worker can replay it from memory.
+            FILE *script = strcmp(batch_path, "-") ? fopen(batch_path, "r") : stdin;
+            size_t len = 0;
+            size_t cap = 4096;
+            size_t n;
+
+            if (!script) {
+                perror(batch_path);
+                return 1;
+            }
+            batch_text = malloc(cap);
+            while (batch_text && (n = fread(batch_text + len, 1, cap - len - 1, script)) > 0) {
+                len += n;
+                if (len + 1 == cap) {
+                    cap *= 2;
+                    batch_text = realloc(batch_text, cap);
+                }
+            }
+            if (script != stdin)
+                fclose(script);
+            if (!batch_text) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+            batch_text[len] = '\0';
+        }
+
+        ret = run_fanout(targets_path, host_port, direct_connection,
+                         address, have_value, value, write_only, batch_text);
+        free(batch_text);
+        return ret;
+    }
+
     conn = eb_connect(host_address, host_port, direct_connection);
     if (!conn) {
         fprintf(stderr, "Unable to create connection\n");
         return 1;
     }
 
+    if (batch_path) {
+        FILE *script = strcmp(batch_path, "-") ? fopen(batch_path, "r") : stdin;
+        int ret;
+
+        if (!script) {
+            perror(batch_path);
+            eb_disconnect(&conn);
+            return 1;
+        }
+        ret = run_batch(conn, script, stdout);
+        if (script != stdin)
+            fclose(script);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
+    if (poll_interval > 0)
+        return poll_address(conn, address, poll_interval, on_change);
+
+    if (load_path) {
+        int ret = load_file(conn, address, load_path);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
+    if (save_path) {
+        int ret;
+        if (count == 0) {
+            fprintf(stderr, "--save requires --count\n");
+            eb_disconnect(&conn);
+            return 1;
+        }
+        ret = save_file(conn, address, count, save_path);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
+    if (bench_seconds > 0) {
+        int ret = bench_link(conn, address, bench_seconds);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
+    if (have_fill) {
+        int ret;
+        if (count == 0) {
+            fprintf(stderr, "--fill requires --count\n");
+            eb_disconnect(&conn);
+            return 1;
+        }
+        ret = fill_range(conn, address, fill_value, count);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
+    if (count > 0) {
+        int ret = dump_range(conn, address, count, stdout);
+        eb_disconnect(&conn);
+        return ret;
+    }
+
     if (have_value) {
         if (write_only) {
             eb_write32(conn, value, address);
@@ -0,0 +1,99 @@
+//! Benchmarks for the bridge hot paths, run against the loopback
+//! backend so they measure the bridge machinery itself -- the
+//! scheduler thread, request merging, and the `Read`/`Write`
+//! buffering -- rather than any transport.
+//!
+//! Run with `cargo bench --features loopback`.
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use std::io::{Read, Seek, SeekFrom, Write};
+use wishbone_bridge::{Bridge, LoopbackBridge};
+
+/// Sizes used for the burst and `Read`/`Write` benchmarks, spanning a
+/// single merged burst up to a multi-chunk transfer.
+const BURST_LENGTHS: &[u32] = &[16, 256, 4096, 65536];
+
+fn loopback() -> Bridge {
+    let bridge = LoopbackBridge::new().create().unwrap();
+    bridge.connect().unwrap();
+    bridge
+}
+
+fn single_word(c: &mut Criterion) {
+    let bridge = loopback();
+    c.bench_function("peek", |b| b.iter(|| bridge.peek(0x100).unwrap()));
+    c.bench_function("poke", |b| b.iter(|| bridge.poke(0x100, 0x1234_5678).unwrap()));
+}
+
+fn burst_read(c: &mut Criterion) {
+    let bridge = loopback();
+    let mut group = c.benchmark_group("burst_read");
+    for &len in BURST_LENGTHS {
+        group.throughput(Throughput::Bytes(u64::from(len)));
+        group.bench_with_input(BenchmarkId::from_parameter(len), &len, |b, &len| {
+            b.iter(|| bridge.burst_read(0, len).unwrap())
+        });
+    }
+    group.finish();
+
+    // The allocation-free variant, reusing one caller-owned buffer
+    let mut group = c.benchmark_group("burst_read_into");
+    for &len in BURST_LENGTHS {
+        group.throughput(Throughput::Bytes(u64::from(len)));
+        group.bench_with_input(BenchmarkId::from_parameter(len), &len, |b, &len| {
+            let mut buf = vec![0; len as usize];
+            b.iter(|| bridge.burst_read_into(0, &mut buf).unwrap())
+        });
+    }
+    group.finish();
+}
+
+fn burst_write(c: &mut Criterion) {
+    let bridge = loopback();
+    let mut group = c.benchmark_group("burst_write");
+    for &len in BURST_LENGTHS {
+        group.throughput(Throughput::Bytes(u64::from(len)));
+        group.bench_with_input(BenchmarkId::from_parameter(len), &len, |b, &len| {
+            let data = vec![0xa5; len as usize];
+            b.iter(|| bridge.burst_write(0, &data).unwrap())
+        });
+    }
+    group.finish();
+}
+
+/// The `io::Read` and `io::Write` implementations, which add
+/// read-ahead and write-coalescing buffers on top of the bursts.
+fn io_traits(c: &mut Criterion) {
+    let bridge = loopback();
+    let mut group = c.benchmark_group("io_read");
+    for &len in BURST_LENGTHS {
+        group.throughput(Throughput::Bytes(u64::from(len)));
+        group.bench_with_input(BenchmarkId::from_parameter(len), &len, |b, &len| {
+            let mut bridge = bridge.clone();
+            let mut buf = vec![0; len as usize];
+            b.iter(|| {
+                bridge.seek(SeekFrom::Start(0)).unwrap();
+                bridge.read_exact(&mut buf).unwrap();
+            })
+        });
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("io_write");
+    for &len in BURST_LENGTHS {
+        group.throughput(Throughput::Bytes(u64::from(len)));
+        group.bench_with_input(BenchmarkId::from_parameter(len), &len, |b, &len| {
+            let mut bridge = bridge.clone();
+            let data = vec![0xa5; len as usize];
+            b.iter(|| {
+                bridge.seek(SeekFrom::Start(0)).unwrap();
+                bridge.write_all(&data).unwrap();
+                bridge.flush().unwrap();
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, single_word, burst_read, burst_write, io_traits);
+criterion_main!(benches);
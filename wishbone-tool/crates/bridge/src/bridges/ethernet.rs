@@ -74,22 +74,39 @@ impl EthernetBridge {
     }
 }
 
+/// Reconnect backoff bounds.  The first retry comes within a few
+/// milliseconds so a board that bounces is picked up almost
+/// immediately; repeated failures back off exponentially so a board
+/// that is gone for good is not hammered.
+const RECONNECT_BACKOFF_MIN: Duration = Duration::from_millis(4);
+const RECONNECT_BACKOFF_MAX: Duration = Duration::from_millis(2000);
+
+/// A UDP socket plus what has been learned about the target's reply
+/// headers.  `seq_echo` starts unknown and is settled by the first
+/// multi-packet exchange: only targets that echo our sequence ids may
+/// use the windowed path, since replies cannot be correlated without
+/// the echo.
+struct UdpConnection {
+    socket: UdpSocket,
+    seq_echo: Option<bool>,
+}
+
 enum EthernetConnection {
-    UDP(UdpSocket),
+    UDP(UdpConnection),
     TCP(TcpStream),
 }
 
 impl EthernetConnection {
     pub fn set_write_timeout(&self, dur: Option<Duration>) -> ::std::io::Result<()> {
         match self {
-            EthernetConnection::UDP(u) => u.set_write_timeout(dur),
+            EthernetConnection::UDP(u) => u.socket.set_write_timeout(dur),
             EthernetConnection::TCP(t) => t.set_write_timeout(dur),
         }
     }
 
     pub fn set_read_timeout(&self, dur: Option<Duration>) -> ::std::io::Result<()> {
         match self {
-            EthernetConnection::UDP(u) => u.set_read_timeout(dur),
+            EthernetConnection::UDP(u) => u.socket.set_read_timeout(dur),
             EthernetConnection::TCP(t) => t.set_read_timeout(dur),
         }
     }
@@ -108,6 +125,10 @@ enum ConnectThreadRequests {
     Exit,
     Poke(u32 /* addr */, u32 /* val */),
     Peek(u32 /* addr */),
+    BurstRead(u32 /* addr */, u32 /* len */),
+    BurstWrite(u32 /* addr */, Vec<u8> /* write data */),
+    PeekMany(Vec<u32> /* addrs */),
+    PokeMany(Vec<(u32, u32)> /* (addr, value) pairs */),
 }
 
 #[derive(Debug)]
@@ -116,6 +137,86 @@ enum ConnectThreadResponses {
     OpenedDevice,
     PeekResult(Result<u32, BridgeError>),
     PokeResult(Result<(), BridgeError>),
+    BurstReadResult(Result<Vec<u8>, BridgeError>),
+    BurstWriteResult(Result<(), BridgeError>),
+    PeekManyResult(Result<Vec<u32>, BridgeError>),
+    PokeManyResult(Result<(), BridgeError>),
+}
+
+/// An Etherbone record holds at most 255 operations, since wcount and
+/// rcount are one byte each.
+const MAX_RECORD_COUNT: u32 = 255;
+
+/// Number of Etherbone request packets kept in flight over UDP, so
+/// multi-packet workloads scale with bandwidth rather than round-trip
+/// time.
+const UDP_WINDOW: usize = 8;
+
+/// How many consecutive receive timeouts (with retransmission) are
+/// tolerated before a UDP exchange is abandoned.
+const UDP_MAX_TIMEOUTS: u32 = 25;
+
+/// Preserialized single-word packet templates.  The hot path copies
+/// one onto the stack and patches the address and value fields.
+const POKE_TEMPLATE: [u8; 20] = [
+    0x4e, // Magic byte 0
+    0x6f, // Magic byte 1
+    0x10, // Version 1, all other flags 0
+    0x44, // Address is 32-bits, port is 32-bits
+    0, 0, 0, 0, // Padding
+    0,    // No Wishbone flags are set (cyc, wca, wff, etc.)
+    0x0f, // Byte enable
+    1,    // Write count
+    0,    // Read count
+    0, 0, 0, 0, // Address
+    0, 0, 0, 0, // Value
+];
+
+const PEEK_TEMPLATE: [u8; 20] = [
+    0x4e, // Magic byte 0
+    0x6f, // Magic byte 1
+    0x10, // Version 1, all other flags 0
+    0x44, // Address is 32-bits, port is 32-bits
+    0, 0, 0, 0, // Padding
+    0,    // No Wishbone flags are set (cyc, wca, wff, etc.)
+    0x0f, // Byte enable
+    0,    // Write count
+    1,    // Read count
+    0, 0, 0, 0, // Base return address
+    0, 0, 0, 0, // Address to read
+];
+
+/// A pool of reusable packet buffers for the multi-packet paths, so
+/// steady-state operation on the connect thread allocates nothing.
+struct PacketPool {
+    free: Vec<Vec<u8>>,
+}
+
+impl PacketPool {
+    fn new() -> PacketPool {
+        PacketPool { free: Vec::new() }
+    }
+
+    /// Fetch a zeroed buffer of `len` bytes, reusing a previously
+    /// returned one when possible.
+    fn get(&mut self, len: usize) -> Vec<u8> {
+        match self.free.pop() {
+            Some(mut buf) => {
+                buf.clear();
+                buf.resize(len, 0);
+                buf
+            }
+            None => vec![0u8; len],
+        }
+    }
+
+    /// Return a buffer to the pool.  The pool is bounded so a huge
+    /// one-off burst doesn't pin its buffers forever.
+    fn put(&mut self, buf: Vec<u8>) {
+        if self.free.len() < 2 * UDP_WINDOW {
+            self.free.push(buf);
+        }
+    }
 }
 
 impl Clone for EthernetBridgeInner {
@@ -150,15 +251,34 @@ impl EthernetBridgeInner {
         })
     }
 
+    /// Wait out the current reconnect delay plus up to half of it in
+    /// jitter, then double the delay up to the cap.  The jitter is
+    /// derived from the clock so many clients dropped by one event do
+    /// not retry in lockstep, without pulling an RNG into this crate.
+    fn backoff_park(delay: &mut Duration) {
+        let jitter_ns = std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .map(|d| u64::from(d.subsec_nanos()))
+            .unwrap_or(0)
+            % (delay.as_nanos() as u64 / 2).max(1);
+        thread::park_timeout(*delay + Duration::from_nanos(jitter_ns));
+        *delay = (*delay * 2).min(RECONNECT_BACKOFF_MAX);
+    }
+
     fn ethernet_thread(
         tx: Arc<(Mutex<Option<ConnectThreadResponses>>, Condvar)>,
         rx: Receiver<ConnectThreadRequests>,
         cfg: EthernetBridge,
     ) {
+        // The address was resolved once when the EthernetBridge was
+        // built, so reconnects reuse the cached SocketAddr instead of
+        // going back to the resolver.
         let mut remote_addr = cfg.addr;
         let mut print_waiting_message = true;
         let mut first_run = true;
+        let mut backoff = RECONNECT_BACKOFF_MIN;
         let &(ref response, ref cvar) = &*tx;
+        let mut pool = PacketPool::new();
         loop {
             let mut connection = if cfg.protocol == EthernetBridgeProtocol::TCP {
                 match TcpStream::connect(remote_addr) {
@@ -171,7 +291,7 @@ impl EthernetBridgeInner {
                             print_waiting_message = false;
                             error!("unable to open ethernet host {}, will wait for it to appear again: {}", remote_addr, e);
                         }
-                        thread::park_timeout(Duration::from_millis(500));
+                        Self::backoff_park(&mut backoff);
                         continue;
                     }
                 }
@@ -179,18 +299,22 @@ impl EthernetBridgeInner {
                 match UdpSocket::bind(format!("0.0.0.0:{}", remote_addr.port())) {
                     Ok(conn) => {
                         info!("Re-opened ethernet host {}", remote_addr);
-                        EthernetConnection::UDP(conn)
+                        EthernetConnection::UDP(UdpConnection {
+                            socket: conn,
+                            seq_echo: None,
+                        })
                     }
                     Err(e) => {
                         if print_waiting_message {
                             print_waiting_message = false;
                             error!("unable to open ethernet host {}, will wait for it to appear again: {}", remote_addr, e);
                         }
-                        thread::park_timeout(Duration::from_millis(500));
+                        Self::backoff_park(&mut backoff);
                         continue;
                     }
                 }
             };
+            backoff = RECONNECT_BACKOFF_MIN;
 
             if first_run {
                 *response.lock().unwrap() = Some(ConnectThreadResponses::OpenedDevice);
@@ -245,11 +369,55 @@ impl EthernetBridgeInner {
                                 Some(ConnectThreadResponses::PokeResult(result));
                             cvar.notify_one();
                         }
+                        ConnectThreadRequests::BurstRead(addr, len) => {
+                            let result =
+                                Self::do_burst_read(&mut pool, &mut connection, &remote_addr, addr, len);
+                            if let Err(err) = &result {
+                                result_error = format!("burst read {:?} @ {:08x}", err, addr);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstReadResult(result));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::BurstWrite(addr, data) => {
+                            let result =
+                                Self::do_burst_write(&mut pool, &mut connection, &remote_addr, addr, &data);
+                            if let Err(err) = &result {
+                                result_error = format!("burst write {:?} @ {:08x}", err, addr);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstWriteResult(result));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::PeekMany(addrs) => {
+                            let result =
+                                Self::do_peek_many(&mut pool, &mut connection, &remote_addr, &addrs);
+                            if let Err(err) = &result {
+                                result_error = format!("peek many {:?}", err);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::PeekManyResult(result));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::PokeMany(ops) => {
+                            let result =
+                                Self::do_poke_many(&mut pool, &mut connection, &remote_addr, &ops);
+                            if let Err(err) = &result {
+                                result_error = format!("poke many {:?}", err);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::PokeManyResult(result));
+                            cvar.notify_one();
+                        }
                     },
                 }
             }
             error!("ethernet connection was closed: {}", result_error);
-            thread::park_timeout(Duration::from_millis(500));
+            Self::backoff_park(&mut backoff);
 
             // Respond to any messages in the buffer with NotConnected.  As soon
             // as the channel is empty, loop back to the start of this function.
@@ -279,6 +447,34 @@ impl EthernetBridgeInner {
                         ConnectThreadRequests::StartPolling(new_remote_addr) => {
                             remote_addr = new_remote_addr
                         }
+                        ConnectThreadRequests::BurstRead(_addr, _len) => {
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstReadResult(Err(
+                                    BridgeError::NotConnected,
+                                )));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::BurstWrite(_addr, _data) => {
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstWriteResult(Err(
+                                    BridgeError::NotConnected,
+                                )));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::PeekMany(_addrs) => {
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::PeekManyResult(Err(
+                                    BridgeError::NotConnected,
+                                )));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::PokeMany(_ops) => {
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::PokeManyResult(Err(
+                                    BridgeError::NotConnected,
+                                )));
+                            cvar.notify_one();
+                        }
                     },
                 }
             }
@@ -313,30 +509,11 @@ impl EthernetBridgeInner {
         value: u32,
     ) -> Result<(), BridgeError> {
         debug!("POKE @ {:08x} -> {:08x}", addr, value);
-        let mut buffer: [u8; 20] = [
-            // 0
-            0x4e, // Magic byte 0
-            0x6f, // Magic byte 1
-            0x10, // Version 1, all other flags 0
-            0x44, // Address is 32-bits, port is 32-bits
-            // 4
-            0, // Padding
-            0, // Padding
-            0, // Padding
-            0, // Padding
-            // 8 - Record
-            0,    // No Wishbone flags are set (cyc, wca, wff, etc.)
-            0x0f, // Byte enable
-            1,    // Write count
-            0,    // Read count
-            // 12 - Address
-            0, 0, 0, 0, // 16 - Value
-            0, 0, 0, 0,
-        ];
+        let mut buffer = POKE_TEMPLATE;
         BigEndian::write_u32(&mut buffer[12..16], addr);
         BigEndian::write_u32(&mut buffer[16..20], value);
         match connection {
-            EthernetConnection::UDP(u) => u.send_to(&buffer, remote_addr)?,
+            EthernetConnection::UDP(u) => u.socket.send_to(&buffer, remote_addr)?,
             EthernetConnection::TCP(t) => t.write(&buffer)?,
         };
         Ok(())
@@ -347,31 +524,12 @@ impl EthernetBridgeInner {
         remote_addr: &SocketAddr,
         addr: u32,
     ) -> Result<u32, BridgeError> {
-        let mut buffer: [u8; 20] = [
-            // 0
-            0x4e, // Magic byte 0
-            0x6f, // Magic byte 1
-            0x10, // Version 1, all other flags 0
-            0x44, // Address is 32-bits, port is 32-bits
-            // 4
-            0, // Padding
-            0, // Padding
-            0, // Padding
-            0, // Padding
-            // 8 - Record
-            0,    // No Wishbone flags are set (cyc, wca, wff, etc.)
-            0x0f, // Byte enable
-            0,    // Write count
-            1,    // Read count
-            // 12 - Address
-            0, 0, 0, 0, // 16 - Value
-            0, 0, 0, 0,
-        ];
+        let mut buffer = PEEK_TEMPLATE;
         BigEndian::write_u32(&mut buffer[16..20], addr);
         let amt = match connection {
             EthernetConnection::UDP(u) => {
-                u.send_to(&buffer, remote_addr)?;
-                let (amt, _src) = u.recv_from(&mut buffer)?;
+                u.socket.send_to(&buffer, remote_addr)?;
+                let (amt, _src) = u.socket.recv_from(&mut buffer)?;
                 amt
             }
             EthernetConnection::TCP(t) => {
@@ -388,6 +546,488 @@ impl EthernetBridgeInner {
         Ok(val)
     }
 
+    /// Fill in the constant Etherbone header and record header for a
+    /// multi-operation packet.
+    fn fill_header(buffer: &mut [u8], wcount: u8, rcount: u8) {
+        buffer[0..12].copy_from_slice(&[
+            0x4e, // Magic byte 0
+            0x6f, // Magic byte 1
+            0x10, // Version 1, all other flags 0
+            0x44, // Address is 32-bits, port is 32-bits
+            0, 0, 0, 0,      // Padding
+            0,      // No Wishbone flags are set (cyc, wca, wff, etc.)
+            0x0f,   // Byte enable
+            wcount, // Write count
+            rcount, // Read count
+        ]);
+    }
+
+    /// Exchange a list of request packets for their same-sized replies.
+    /// TCP streams them sequentially; UDP keeps a window of packets in
+    /// flight, tagged with a sequence id carried in the header padding
+    /// bytes, so replies can be matched out of order and losses
+    /// retransmitted.  The windowed path is only used once the target
+    /// has demonstrated that it echoes our sequence ids; otherwise the
+    /// exchange degrades to one packet in flight.
+    fn exchange_packets(
+        pool: &mut PacketPool,
+        connection: &mut EthernetConnection,
+        remote_addr: &SocketAddr,
+        requests: &mut [Vec<u8>],
+    ) -> Result<Vec<Vec<u8>>, BridgeError> {
+        let mut replies: Vec<Vec<u8>> = requests.iter().map(|r| pool.get(r.len())).collect();
+        match connection {
+            EthernetConnection::TCP(t) => {
+                for (request, reply) in requests.iter().zip(replies.iter_mut()) {
+                    t.write_all(request)?;
+                    t.read_exact(reply)?;
+                }
+            }
+            EthernetConnection::UDP(u) => {
+                // Sequence ids are 1-based so that a target which
+                // regenerates its reply header -- returning the padding
+                // as zero instead of echoing ours -- can never alias a
+                // valid id.
+                for (i, request) in requests.iter_mut().enumerate() {
+                    BigEndian::write_u16(&mut request[4..6], (i + 1) as u16);
+                }
+                u.socket.set_read_timeout(Some(Duration::from_millis(200)))?;
+                let result = Self::udp_exchange(u, remote_addr, requests, &mut replies);
+                u.socket.set_read_timeout(None)?;
+                result?;
+            }
+        }
+        Ok(replies)
+    }
+
+    /// Exchange requests for replies over UDP.  The first exchange on a
+    /// connection sends a single packet and checks whether the target
+    /// echoed its sequence id; only when it did is the windowed path
+    /// used for the rest, since without the echo replies cannot be
+    /// correlated and a pipelined window would misattribute them.
+    fn udp_exchange(
+        connection: &mut UdpConnection,
+        remote_addr: &SocketAddr,
+        requests: &[Vec<u8>],
+        replies: &mut [Vec<u8>],
+    ) -> Result<(), BridgeError> {
+        let mut probed = 0;
+        if connection.seq_echo.is_none() {
+            let echoed = Self::udp_exchange_serial(
+                &connection.socket,
+                remote_addr,
+                &requests[..1],
+                &mut replies[..1],
+            )?;
+            if !echoed {
+                debug!("target does not echo sequence ids, staying with one packet in flight");
+            }
+            connection.seq_echo = Some(echoed);
+            probed = 1;
+        }
+        if probed == requests.len() {
+            return Ok(());
+        }
+        if connection.seq_echo == Some(true) {
+            Self::udp_exchange_windowed(&connection.socket, remote_addr, requests, replies, probed)
+        } else {
+            Self::udp_exchange_serial(
+                &connection.socket,
+                remote_addr,
+                &requests[probed..],
+                &mut replies[probed..],
+            )
+            .map(|_| ())
+        }
+    }
+
+    /// Stop-and-wait exchange: one packet in flight at a time,
+    /// retransmitted on timeout.  Replies must carry the Etherbone
+    /// magic and the expected length.  Returns whether the final reply
+    /// echoed its request's sequence id.
+    fn udp_exchange_serial(
+        socket: &UdpSocket,
+        remote_addr: &SocketAddr,
+        requests: &[Vec<u8>],
+        replies: &mut [Vec<u8>],
+    ) -> Result<bool, BridgeError> {
+        let mut scratch = [0u8; 2048];
+        let mut echoed = false;
+        for (request, reply) in requests.iter().zip(replies.iter_mut()) {
+            let mut timeouts = 0;
+            socket.send_to(request, remote_addr)?;
+            loop {
+                match socket.recv_from(&mut scratch) {
+                    Ok((amt, _src)) => {
+                        if amt < 16
+                            || scratch[0] != 0x4e
+                            || scratch[1] != 0x6f
+                            || amt != reply.len()
+                        {
+                            continue;
+                        }
+                        reply.copy_from_slice(&scratch[..amt]);
+                        echoed = BigEndian::read_u16(&scratch[4..6])
+                            == BigEndian::read_u16(&request[4..6]);
+                        break;
+                    }
+                    Err(ref e)
+                        if e.kind() == std::io::ErrorKind::WouldBlock
+                            || e.kind() == std::io::ErrorKind::TimedOut =>
+                    {
+                        timeouts += 1;
+                        if timeouts > UDP_MAX_TIMEOUTS {
+                            return Err(BridgeError::Timeout);
+                        }
+                        debug!("UDP exchange timed out, retransmitting");
+                        socket.send_to(request, remote_addr)?;
+                    }
+                    Err(e) => return Err(e.into()),
+                }
+            }
+        }
+        Ok(echoed)
+    }
+
+    /// Windowed exchange for targets known to echo sequence ids.  The
+    /// first `already_done` packets have been exchanged by the caller.
+    fn udp_exchange_windowed(
+        socket: &UdpSocket,
+        remote_addr: &SocketAddr,
+        requests: &[Vec<u8>],
+        replies: &mut [Vec<u8>],
+        already_done: usize,
+    ) -> Result<(), BridgeError> {
+        let mut done = vec![false; requests.len()];
+        for d in done.iter_mut().take(already_done) {
+            *d = true;
+        }
+        let mut outstanding = 0;
+        let mut next = already_done;
+        let mut remaining = requests.len() - already_done;
+        let mut timeouts = 0;
+        let mut scratch = [0u8; 2048];
+        while remaining > 0 {
+            while next < requests.len() && outstanding < UDP_WINDOW {
+                socket.send_to(&requests[next], remote_addr)?;
+                outstanding += 1;
+                next += 1;
+            }
+            match socket.recv_from(&mut scratch) {
+                Ok((amt, _src)) => {
+                    // Drop datagrams without the Etherbone magic, and
+                    // replies whose sequence id decodes to zero -- a
+                    // regenerated header rather than an echo of ours.
+                    if amt < 16 || scratch[0] != 0x4e || scratch[1] != 0x6f {
+                        continue;
+                    }
+                    let seq = BigEndian::read_u16(&scratch[4..6]) as usize;
+                    if seq == 0 {
+                        continue;
+                    }
+                    let idx = seq - 1;
+                    if idx < next && !done[idx] && amt == replies[idx].len() {
+                        replies[idx].copy_from_slice(&scratch[..amt]);
+                        done[idx] = true;
+                        outstanding -= 1;
+                        remaining -= 1;
+                        timeouts = 0;
+                    }
+                }
+                Err(ref e)
+                    if e.kind() == std::io::ErrorKind::WouldBlock
+                        || e.kind() == std::io::ErrorKind::TimedOut =>
+                {
+                    timeouts += 1;
+                    if timeouts > UDP_MAX_TIMEOUTS {
+                        return Err(BridgeError::Timeout);
+                    }
+                    debug!("UDP exchange timed out, retransmitting unacknowledged packets");
+                    for i in 0..next {
+                        if !done[i] {
+                            socket.send_to(&requests[i], remote_addr)?;
+                        }
+                    }
+                }
+                Err(e) => return Err(e.into()),
+            }
+        }
+        Ok(())
+    }
+
+    fn do_burst_read(
+        pool: &mut PacketPool,
+        connection: &mut EthernetConnection,
+        remote_addr: &SocketAddr,
+        addr: u32,
+        len: u32,
+    ) -> Result<Vec<u8>, BridgeError> {
+        let mut data = Vec::with_capacity(len as usize);
+        let end = addr.wrapping_add(len);
+        let mut cur = addr & !3;
+        let mut requests = Vec::new();
+        let mut bases = Vec::new();
+        while cur < end {
+            let nwords = ((end - cur + 3) / 4).min(MAX_RECORD_COUNT);
+            let mut buffer = pool.get(16 + nwords as usize * 4);
+            Self::fill_header(&mut buffer, 0, nwords as u8);
+            // Bytes 12..16 hold the base return address and stay 0
+            for i in 0..nwords {
+                BigEndian::write_u32(
+                    &mut buffer[16 + i as usize * 4..20 + i as usize * 4],
+                    cur + i * 4,
+                );
+            }
+            requests.push(buffer);
+            bases.push(cur);
+            cur += nwords * 4;
+        }
+
+        let replies = Self::exchange_packets(pool, connection, remote_addr, &mut requests)?;
+        for request in requests {
+            pool.put(request);
+        }
+
+        for (reply, base) in replies.iter().zip(bases) {
+            let nwords = (reply.len() - 16) / 4;
+            for i in 0..nwords {
+                let word =
+                    BigEndian::read_u32(&reply[16 + i * 4..20 + i * 4]).to_le_bytes();
+                for (j, b) in word.iter().enumerate() {
+                    let byte_addr = base + i as u32 * 4 + j as u32;
+                    if byte_addr >= addr && byte_addr < end {
+                        data.push(*b);
+                    }
+                }
+            }
+        }
+        for reply in replies {
+            pool.put(reply);
+        }
+        debug!("BURST_READ @ {:08x} ({} bytes)", addr, data.len());
+        Ok(data)
+    }
+
+    fn do_burst_write(
+        pool: &mut PacketPool,
+        connection: &mut EthernetConnection,
+        remote_addr: &SocketAddr,
+        addr: u32,
+        data: &[u8],
+    ) -> Result<(), BridgeError> {
+        let end = addr.wrapping_add(data.len() as u32);
+        let mut cur = addr & !3;
+        while cur < end {
+            let nwords = ((end - cur + 3) / 4).min(MAX_RECORD_COUNT);
+            let mut buffer = pool.get(16 + nwords as usize * 4);
+            Self::fill_header(&mut buffer, nwords as u8, 0);
+            BigEndian::write_u32(&mut buffer[12..16], cur);
+            for i in 0..nwords {
+                let word_addr = cur + i * 4;
+                let value = if word_addr >= addr && word_addr + 4 <= end {
+                    let offset = (word_addr - addr) as usize;
+                    u32::from_le_bytes([
+                        data[offset],
+                        data[offset + 1],
+                        data[offset + 2],
+                        data[offset + 3],
+                    ])
+                } else {
+                    // Unaligned head or tail byte: read-modify-write
+                    let mut word =
+                        Self::do_peek(connection, remote_addr, word_addr)?.to_le_bytes();
+                    for (j, b) in word.iter_mut().enumerate() {
+                        let byte_addr = word_addr + j as u32;
+                        if byte_addr >= addr && byte_addr < end {
+                            *b = data[(byte_addr - addr) as usize];
+                        }
+                    }
+                    u32::from_le_bytes(word)
+                };
+                BigEndian::write_u32(&mut buffer[16 + i as usize * 4..20 + i as usize * 4], value);
+            }
+
+            match connection {
+                EthernetConnection::UDP(u) => u.socket.send_to(&buffer, remote_addr)?,
+                EthernetConnection::TCP(t) => {
+                    t.write_all(&buffer)?;
+                    buffer.len()
+                }
+            };
+            pool.put(buffer);
+            cur += nwords * 4;
+        }
+        debug!("BURST_WRITE @ {:08x} ({} bytes)", addr, data.len());
+        Ok(())
+    }
+
+    fn do_peek_many(
+        pool: &mut PacketPool,
+        connection: &mut EthernetConnection,
+        remote_addr: &SocketAddr,
+        addrs: &[u32],
+    ) -> Result<Vec<u32>, BridgeError> {
+        let mut values = Vec::with_capacity(addrs.len());
+        // A read record carries arbitrary, non-incrementing addresses,
+        // so one packet satisfies up to 255 scattered reads
+        let mut requests = Vec::new();
+        for chunk in addrs.chunks(MAX_RECORD_COUNT as usize) {
+            let mut buffer = pool.get(16 + chunk.len() * 4);
+            Self::fill_header(&mut buffer, 0, chunk.len() as u8);
+            for (i, addr) in chunk.iter().enumerate() {
+                BigEndian::write_u32(&mut buffer[16 + i * 4..20 + i * 4], *addr);
+            }
+            requests.push(buffer);
+        }
+
+        let replies = Self::exchange_packets(pool, connection, remote_addr, &mut requests)?;
+        for request in requests {
+            pool.put(request);
+        }
+        for reply in replies {
+            let nwords = (reply.len() - 16) / 4;
+            for i in 0..nwords {
+                values.push(BigEndian::read_u32(&reply[16 + i * 4..20 + i * 4]));
+            }
+            pool.put(reply);
+        }
+        debug!("PEEK_MANY ({} addresses)", addrs.len());
+        Ok(values)
+    }
+
+    fn do_poke_many(
+        pool: &mut PacketPool,
+        connection: &mut EthernetConnection,
+        remote_addr: &SocketAddr,
+        ops: &[(u32, u32)],
+    ) -> Result<(), BridgeError> {
+        // Write records increment from a base address, so each
+        // contiguous run becomes one record; several records share a
+        // packet until it reaches the same size cap as a full burst.
+        let mut packet = pool.get(0);
+        packet.extend_from_slice(&[0x4e, 0x6f, 0x10, 0x44, 0, 0, 0, 0]);
+        let mut words_queued = 0;
+        let mut i = 0;
+        while i < ops.len() {
+            let mut run = 1;
+            while i + run < ops.len()
+                && run < MAX_RECORD_COUNT as usize
+                && ops[i + run].0 == ops[i].0.wrapping_add(4 * run as u32)
+            {
+                run += 1;
+            }
+
+            if words_queued != 0 && words_queued + run > MAX_RECORD_COUNT as usize {
+                match connection {
+                    EthernetConnection::UDP(u) => {
+                        u.socket.send_to(&packet, remote_addr)?;
+                    }
+                    EthernetConnection::TCP(t) => t.write_all(&packet)?,
+                }
+                packet.truncate(8);
+                words_queued = 0;
+            }
+
+            packet.extend_from_slice(&[0, 0x0f, run as u8, 0]);
+            let mut word = [0u8; 4];
+            BigEndian::write_u32(&mut word, ops[i].0);
+            packet.extend_from_slice(&word);
+            for op in &ops[i..i + run] {
+                BigEndian::write_u32(&mut word, op.1);
+                packet.extend_from_slice(&word);
+            }
+            words_queued += run;
+            i += run;
+        }
+        if words_queued != 0 {
+            match connection {
+                EthernetConnection::UDP(u) => {
+                    u.socket.send_to(&packet, remote_addr)?;
+                }
+                EthernetConnection::TCP(t) => t.write_all(&packet)?,
+            }
+        }
+        pool.put(packet);
+        debug!("POKE_MANY ({} operations)", ops.len());
+        Ok(())
+    }
+
+    pub fn peek_many(&self, addrs: &[u32]) -> Result<Vec<u32>, BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::PeekMany(addrs.to_vec()))
+            .expect("Unable to send peek many to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::PeekManyResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge peek many response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
+    pub fn poke_many(&self, ops: &[(u32, u32)]) -> Result<(), BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::PokeMany(ops.to_vec()))
+            .expect("Unable to send poke many to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::PokeManyResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge poke many response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
+    pub fn burst_read(&self, addr: u32, len: u32) -> Result<Vec<u8>, BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::BurstRead(addr, len))
+            .expect("Unable to send burst read to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::BurstReadResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge burst read response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
+    pub fn burst_write(&self, addr: u32, data: &[u8]) -> Result<(), BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::BurstWrite(addr, data.to_vec()))
+            .expect("Unable to send burst write to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::BurstWriteResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge burst write response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
     pub fn poke(&self, addr: u32, value: u32) -> Result<(), BridgeError> {
         let &(ref lock, ref cvar) = &*self.main_rx;
         let mut _mtx = lock.lock().unwrap();
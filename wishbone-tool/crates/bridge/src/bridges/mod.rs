@@ -1,5 +1,7 @@
 #[cfg(feature = "ethernet")]
 pub mod ethernet;
+#[cfg(feature = "loopback")]
+pub mod loopback;
 #[cfg(feature = "pcie")]
 pub mod pcie;
 #[cfg(feature = "spi")]
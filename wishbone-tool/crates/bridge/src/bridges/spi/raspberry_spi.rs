@@ -1,7 +1,11 @@
+extern crate memmap;
 extern crate rppal;
 extern crate spin_sleep;
 
 use std::fmt;
+use std::fs::OpenOptions;
+use std::io;
+use std::ptr;
 use std::sync::mpsc::{channel, Receiver, Sender, TryRecvError};
 use std::sync::{Arc, Condvar, Mutex};
 use std::thread;
@@ -11,11 +15,75 @@ use log::{debug, error, info};
 
 use rppal::gpio::Mode::{Input, Output};
 use rppal::gpio::{Gpio, IoPin};
+use rppal::spi::{Bus, Mode as SpiMode, SlaveSelect, Spi};
 
 use crate::{BridgeError, SpiBridge};
 
 const TIMEOUT_COUNT: u32 = 20000;
 
+/// Clock rate used when the pins map onto a hardware SPI controller.
+const HARD_SPI_CLOCK_HZ: u32 = 4_000_000;
+
+/// How many dummy bytes a hardware-SPI transaction clocks out while
+/// waiting for the target's acknowledgement.  The controller asserts
+/// chip-select per transfer, so the whole transaction -- command,
+/// polling window and (for reads) the value -- must fit in one
+/// transfer.
+const HARD_SPI_POLL_BYTES: usize = 64;
+
+fn spi_err(e: rppal::spi::Error) -> BridgeError {
+    BridgeError::IoError(io::Error::new(io::ErrorKind::Other, e.to_string()))
+}
+
+/// Direct mapping of the BCM283x GPIO register block through
+/// /dev/gpiomem.  Bit-banging through this avoids the per-call pin
+/// abstraction on the byte hot path; pin directions are still managed
+/// through rppal, only levels are touched here.
+struct FastGpio {
+    _map: memmap::MmapMut,
+    base: *mut u32,
+}
+
+/// Word offsets of the level registers within the GPIO block.
+const GPSET0: usize = 0x1c / 4;
+const GPCLR0: usize = 0x28 / 4;
+const GPLEV0: usize = 0x34 / 4;
+
+impl FastGpio {
+    /// Map the GPIO registers.  Returns None when /dev/gpiomem is not
+    /// available (non-Pi kernel, missing permissions), in which case
+    /// the caller stays on the rppal path.
+    fn new() -> Option<FastGpio> {
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .open("/dev/gpiomem")
+            .ok()?;
+        let mut map = unsafe { memmap::MmapOptions::new().len(4096).map_mut(&file) }.ok()?;
+        let base = map.as_mut_ptr() as *mut u32;
+        Some(FastGpio { _map: map, base })
+    }
+
+    fn set(&self, pin: u8) {
+        unsafe { ptr::write_volatile(self.base.add(GPSET0), 1 << pin) };
+    }
+
+    fn clear(&self, pin: u8) {
+        unsafe { ptr::write_volatile(self.base.add(GPCLR0), 1 << pin) };
+    }
+
+    fn level(&self, pin: u8) -> bool {
+        unsafe { ptr::read_volatile(self.base.add(GPLEV0)) } & (1 << pin) != 0
+    }
+}
+
+/// Either the Pi's hardware SPI peripheral or a set of bit-banged
+/// GPIO pins, depending on which pins were configured.
+enum SpiPort {
+    Hardware(Spi),
+    BitBang(SpiPins),
+}
+
 struct SpiPins {
     copi: IoPin,
     cipo: Option<IoPin>,
@@ -23,6 +91,7 @@ struct SpiPins {
     cs: Option<IoPin>,
     copi_is_input: bool,
     delay: Duration,
+    fast: Option<FastGpio>,
 }
 
 impl fmt::Display for SpiPins {
@@ -113,45 +182,22 @@ impl SpiBridgeInner {
         use ConnectThreadResponses::*;
         let &(ref response, ref cvar) = &*tx;
         loop {
-            let gpio = Gpio::new().expect("unable to get gpio ports");
-            let mut copi_pin = gpio
-                .get(copi)
-                .expect("unable to get spi copi pin")
-                .into_io(Output);
-            copi_pin.set_high();
-            let cipo_pin = if let Some(cipo) = cipo {
-                Some(
-                    gpio.get(cipo)
-                        .expect("unable to get spi cipo pin")
-                        .into_io(Input),
-                )
-            } else {
-                None
-            };
-            let mut clk_pin = gpio
-                .get(clk)
-                .expect("unable to get spi clk pin")
-                .into_io(Output);
-            clk_pin.set_low();
-            let cs_pin = if let Some(cs) = cs {
-                let mut pin = gpio
-                    .get(cs)
-                    .expect("unable to get spi cs pin")
-                    .into_io(Output);
-                pin.set_high();
-                Some(pin)
-            } else {
-                None
-            };
-            let mut pins = SpiPins {
-                copi: copi_pin,
-                cipo: cipo_pin,
-                clk: clk_pin,
-                cs: cs_pin,
-                copi_is_input: false,
-                delay: Duration::from_nanos(333),
+            let mut port = match Self::hardware_bus(copi, cipo, clk, cs) {
+                Some((bus, ss)) => match Spi::new(bus, ss, HARD_SPI_CLOCK_HZ, SpiMode::Mode0) {
+                    Ok(spi) => {
+                        info!(
+                            "re-initialized hardware spi controller at {} Hz",
+                            HARD_SPI_CLOCK_HZ
+                        );
+                        SpiPort::Hardware(spi)
+                    }
+                    Err(e) => {
+                        error!("unable to open hardware spi, bit-banging instead: {}", e);
+                        SpiPort::BitBang(Self::setup_bitbang(copi, cipo, clk, cs))
+                    }
+                },
+                None => SpiPort::BitBang(Self::setup_bitbang(copi, cipo, clk, cs)),
             };
-            info!("re-initialized spi device with pins {}", pins);
 
             let mut keep_going = true;
             while keep_going {
@@ -167,13 +213,13 @@ impl SpiBridgeInner {
                             return;
                         }
                         Peek(addr) => {
-                            let result = Self::do_peek(&mut pins, addr);
+                            let result = Self::do_peek(&mut port, addr);
                             keep_going = result.is_ok();
                             *response.lock().unwrap() = Some(PeekResult(result));
                             cvar.notify_one();
                         }
                         Poke(addr, val) => {
-                            let result = Self::do_poke(&mut pins, addr, val);
+                            let result = Self::do_poke(&mut port, addr, val);
                             keep_going = result.is_ok();
                             *response.lock().unwrap() = Some(PokeResult(result));
                             cvar.notify_one();
@@ -219,6 +265,74 @@ impl SpiBridgeInner {
         Ok(())
     }
 
+    /// Map a pin assignment onto one of the Pi's hardware SPI
+    /// controllers.  Hardware SPI needs all four wires, including a
+    /// chip-select the controller drives itself.
+    fn hardware_bus(
+        copi: u8,
+        cipo: Option<u8>,
+        clk: u8,
+        cs: Option<u8>,
+    ) -> Option<(Bus, SlaveSelect)> {
+        match (copi, cipo, clk, cs) {
+            (10, Some(9), 11, Some(8)) => Some((Bus::Spi0, SlaveSelect::Ss0)),
+            (10, Some(9), 11, Some(7)) => Some((Bus::Spi0, SlaveSelect::Ss1)),
+            (20, Some(19), 21, Some(18)) => Some((Bus::Spi1, SlaveSelect::Ss0)),
+            (20, Some(19), 21, Some(17)) => Some((Bus::Spi1, SlaveSelect::Ss1)),
+            (20, Some(19), 21, Some(16)) => Some((Bus::Spi1, SlaveSelect::Ss2)),
+            _ => None,
+        }
+    }
+
+    /// Claim the configured pins for bit-banging.
+    fn setup_bitbang(copi: u8, cipo: Option<u8>, clk: u8, cs: Option<u8>) -> SpiPins {
+        let gpio = Gpio::new().expect("unable to get gpio ports");
+        let mut copi_pin = gpio
+            .get(copi)
+            .expect("unable to get spi copi pin")
+            .into_io(Output);
+        copi_pin.set_high();
+        let cipo_pin = if let Some(cipo) = cipo {
+            Some(
+                gpio.get(cipo)
+                    .expect("unable to get spi cipo pin")
+                    .into_io(Input),
+            )
+        } else {
+            None
+        };
+        let mut clk_pin = gpio
+            .get(clk)
+            .expect("unable to get spi clk pin")
+            .into_io(Output);
+        clk_pin.set_low();
+        let cs_pin = if let Some(cs) = cs {
+            let mut pin = gpio
+                .get(cs)
+                .expect("unable to get spi cs pin")
+                .into_io(Output);
+            pin.set_high();
+            Some(pin)
+        } else {
+            None
+        };
+        let fast = FastGpio::new();
+        if fast.is_some() {
+            info!("bit-banging through memory-mapped gpio registers");
+        }
+        let pins = SpiPins {
+            copi: copi_pin,
+            cipo: cipo_pin,
+            clk: clk_pin,
+            cs: cs_pin,
+            copi_is_input: false,
+            delay: Duration::from_nanos(333),
+            fast,
+        };
+        info!("re-initialized spi device with pins {}", pins);
+        pins
+    }
+
     /// Get the appropriate input pin.  If COPI is the input, ensure that
     /// it is set as an Input.
     fn get_input(pins: &mut SpiPins) -> (&mut IoPin, &mut IoPin, &Duration) {
@@ -272,6 +386,31 @@ impl SpiBridgeInner {
     }
 
     fn do_write_byte(pins: &mut SpiPins, b: u8) {
+        // Sort out the pin direction through rppal first, then run the
+        // whole byte's edge sequence as raw register writes when the
+        // register block is mapped.
+        let out_num = {
+            let (pin, _clk, _delay) = Self::get_output(pins);
+            pin.pin()
+        };
+        let clk_num = pins.clk.pin();
+        if let Some(ref fast) = pins.fast {
+            if out_num < 32 && clk_num < 32 {
+                let delay = pins.delay;
+                for i in &[7, 6, 5, 4, 3, 2, 1, 0] {
+                    fast.clear(clk_num);
+                    spin_sleep::sleep(delay);
+                    if (b & ((1 << i) as u8)) == 0 {
+                        fast.clear(out_num);
+                    } else {
+                        fast.set(out_num);
+                    }
+                    fast.set(clk_num);
+                    spin_sleep::sleep(delay);
+                }
+                return;
+            }
+        }
         let (pin, clk, delay) = Self::get_output(pins);
         for i in &[7, 6, 5, 4, 3, 2, 1, 0] {
             clk.set_low();
@@ -289,6 +428,27 @@ impl SpiBridgeInner {
     fn do_read_byte(pins: &mut SpiPins) -> u8 {
         let mut val = 0;
 
+        let in_num = {
+            let (pin, _clk, _delay) = Self::get_input(pins);
+            pin.pin()
+        };
+        let clk_num = pins.clk.pin();
+        if let Some(ref fast) = pins.fast {
+            if in_num < 32 && clk_num < 32 {
+                let delay = pins.delay;
+                for i in &[7, 6, 5, 4, 3, 2, 1, 0] {
+                    fast.clear(clk_num);
+                    spin_sleep::sleep(delay);
+                    fast.set(clk_num);
+                    spin_sleep::sleep(delay);
+                    if fast.level(in_num) {
+                        val = val | ((1 << i) as u8);
+                    }
+                }
+                return val;
+            }
+        }
+
         // If running with less than four wires, use the
         // copi pin in INPUT mode.
         let (pin, clk, delay) = Self::get_input(pins);
@@ -305,7 +465,78 @@ impl SpiBridgeInner {
         val
     }
 
-    fn do_poke(pins: &mut SpiPins, addr: u32, value: u32) -> Result<(), BridgeError> {
+    fn do_poke(port: &mut SpiPort, addr: u32, value: u32) -> Result<(), BridgeError> {
+        match port {
+            SpiPort::Hardware(spi) => Self::hard_poke(spi, addr, value),
+            SpiPort::BitBang(pins) => Self::bitbang_poke(pins, addr, value),
+        }
+    }
+
+    fn do_peek(port: &mut SpiPort, addr: u32) -> Result<u32, BridgeError> {
+        match port {
+            SpiPort::Hardware(spi) => Self::hard_peek(spi, addr),
+            SpiPort::BitBang(pins) => Self::bitbang_peek(pins, addr),
+        }
+    }
+
+    fn hard_poke(spi: &mut Spi, addr: u32, value: u32) -> Result<(), BridgeError> {
+        debug!("poke: writing 0x{:08x} to 0x{:08x}", value, addr);
+        let write_cmd = 0;
+
+        // Command, address and value, then a polling window of dummy
+        // bytes during which the target acknowledges the write.
+        let mut request = [0xffu8; 9 + HARD_SPI_POLL_BYTES];
+        request[0] = write_cmd;
+        request[1..5].copy_from_slice(&addr.to_be_bytes());
+        request[5..9].copy_from_slice(&value.to_be_bytes());
+        let mut reply = [0u8; 9 + HARD_SPI_POLL_BYTES];
+        spi.transfer(&mut reply, &request).map_err(spi_err)?;
+
+        for val in &reply[9..] {
+            if *val == write_cmd {
+                return Ok(());
+            }
+            if *val != 0xff {
+                error!("write: val was not {} or 0xff: {:02x}", write_cmd, val);
+                return Err(BridgeError::WrongResponse);
+            }
+        }
+        Err(BridgeError::Timeout)
+    }
+
+    fn hard_peek(spi: &mut Spi, addr: u32) -> Result<u32, BridgeError> {
+        let read_cmd = 1;
+
+        // Command and address, then a polling window that must also
+        // leave room for the four value bytes after the
+        // acknowledgement.
+        let mut request = [0xffu8; 5 + HARD_SPI_POLL_BYTES];
+        request[0] = read_cmd;
+        request[1..5].copy_from_slice(&addr.to_be_bytes());
+        let mut reply = [0u8; 5 + HARD_SPI_POLL_BYTES];
+        spi.transfer(&mut reply, &request).map_err(spi_err)?;
+
+        for i in 5..reply.len() - 4 {
+            let val = reply[i];
+            if val == read_cmd {
+                let value = u32::from_be_bytes([
+                    reply[i + 1],
+                    reply[i + 2],
+                    reply[i + 3],
+                    reply[i + 4],
+                ]);
+                debug!("peek: value 0x{:08x} at addr 0x{:08x}", value, addr);
+                return Ok(value);
+            }
+            if val != 0xff {
+                error!("read: val was not {} or 0xff: {:02x}", read_cmd, val);
+                return Err(BridgeError::WrongResponse);
+            }
+        }
+        Err(BridgeError::Timeout)
+    }
+
+    fn bitbang_poke(pins: &mut SpiPins, addr: u32, value: u32) -> Result<(), BridgeError> {
         debug!("poke: writing 0x{:08x} to 0x{:08x}", value, addr);
         let write_cmd = 0;
 
@@ -346,7 +577,7 @@ impl SpiBridgeInner {
         Ok(())
     }
 
-    fn do_peek(pins: &mut SpiPins, addr: u32) -> Result<u32, BridgeError> {
+    fn bitbang_peek(pins: &mut SpiPins, addr: u32) -> Result<u32, BridgeError> {
         let read_cmd = 1;
         Self::do_start(pins);
 
@@ -7,7 +7,7 @@ use std::time::Duration;
 
 use log::{debug, error, info};
 
-use byteorder::{BigEndian, ReadBytesExt, WriteBytesExt};
+use byteorder::{BigEndian, ByteOrder, ReadBytesExt, WriteBytesExt};
 use serialport::prelude::*;
 
 use crate::{Bridge, BridgeConfig, BridgeError};
@@ -15,11 +15,22 @@ use crate::{Bridge, BridgeConfig, BridgeError};
 /// The default baud rate for the serial port. To change, call `set_baud()`
 pub const DEFAULT_BAUD_RATE: u32 = 115_200;
 
+/// High-speed rates probed during baud negotiation, fastest first.
+/// Common USB serial adapters (FTDI, CP2102) support all of them.
+const BAUD_PROFILES: [u32; 3] = [4_000_000, 3_000_000, 1_000_000];
+
+/// USB-serial latency timer applied at connect time, in milliseconds.
+/// FTDI adapters default to 16 ms, which dominates the round trip of a
+/// 4-byte peek response regardless of baud rate.
+pub const DEFAULT_LATENCY_TIMER_MS: u8 = 1;
+
 /// Describes a connection to a UART or serial port
 #[derive(Clone)]
 pub struct UartBridge {
     serial_port: PathBuf,
     baud: u32,
+    scratch: Option<u32>,
+    latency_timer_ms: u8,
 }
 
 impl UartBridge {
@@ -30,6 +41,8 @@ impl UartBridge {
         Ok(UartBridge {
             serial_port: path.as_ref().to_path_buf(),
             baud: DEFAULT_BAUD_RATE,
+            scratch: None,
+            latency_timer_ms: DEFAULT_LATENCY_TIMER_MS,
         })
     }
 
@@ -38,6 +51,24 @@ impl UartBridge {
         self
     }
 
+    /// Set the adapter latency timer requested at connect time.  Only
+    /// takes effect on Linux for adapters that expose the knob through
+    /// sysfs (FTDI and compatible USB-serial converters).
+    pub fn latency_timer(&mut self, ms: u8) -> &mut UartBridge {
+        self.latency_timer_ms = ms;
+        self
+    }
+
+    /// Enable baud negotiation.  After the port opens at the configured
+    /// baud rate, the bridge reads the scratch register at `scratch_addr`
+    /// as a reference, then retries the link at each rate in
+    /// `BAUD_PROFILES` and locks in the fastest one that reads the
+    /// reference value back without error.
+    pub fn negotiate(&mut self, scratch_addr: u32) -> &mut UartBridge {
+        self.scratch = Some(scratch_addr);
+        self
+    }
+
     pub fn create(&self) -> Result<Bridge, BridgeError> {
         Bridge::new(BridgeConfig::UartBridge(self.clone()))
     }
@@ -70,6 +101,8 @@ enum ConnectThreadRequests {
     Exit,
     Poke(u32 /* addr */, u32 /* val */),
     Peek(u32 /* addr */),
+    BurstRead(u32 /* addr */, u32 /* len */),
+    BurstWrite(u32 /* addr */, Vec<u8> /* write data */),
 }
 
 #[derive(Debug)]
@@ -78,8 +111,14 @@ enum ConnectThreadResponses {
     OpenedDevice,
     PeekResult(Result<u32, BridgeError>),
     PokeResult(Result<(), BridgeError>),
+    BurstReadResult(Result<Vec<u8>, BridgeError>),
+    BurstWriteResult(Result<(), BridgeError>),
 }
 
+/// The serial protocol's length field is a single byte, so one command
+/// covers at most 255 auto-incrementing words.
+const MAX_BURST_WORDS: u32 = 255;
+
 impl UartBridgeInner {
     pub fn new(cfg: &UartBridge) -> Result<Self, BridgeError> {
         let (main_tx, thread_rx) = channel();
@@ -87,11 +126,13 @@ impl UartBridgeInner {
 
         let path = cfg.serial_port.clone();
         let baudrate = cfg.baud;
+        let scratch = cfg.scratch;
+        let latency_ms = cfg.latency_timer_ms;
 
         let thr_cv = cv.clone();
         let thr_path = path.clone();
         let poll_thread = Some(thread::spawn(move || {
-            Self::serial_connect_thread(thr_cv, thread_rx, thr_path, baudrate)
+            Self::serial_connect_thread(thr_cv, thread_rx, thr_path, baudrate, scratch, latency_ms)
         }));
 
         Ok(UartBridgeInner {
@@ -109,12 +150,17 @@ impl UartBridgeInner {
         rx: Receiver<ConnectThreadRequests>,
         path: PathBuf,
         baud: u32,
+        scratch: Option<u32>,
+        latency_ms: u8,
     ) {
         let mut path = path;
         let mut baud = baud;
         let mut print_waiting_message = true;
         let mut first_run = true;
         let &(ref response, ref cvar) = &*tx;
+        // Reusable receive buffer so burst responses are drained with
+        // large size-hinted reads instead of one syscall per word.
+        let mut rx_buf: Vec<u8> = Vec::new();
         loop {
             let mut port = match serialport::open(&path) {
                 Ok(port) => {
@@ -139,6 +185,7 @@ impl UartBridgeInner {
                     continue;
                 }
             };
+            Self::set_latency_timer(&path, latency_ms);
             port.set_baud_rate(baud as _)
                 .unwrap_or_else(|e| error!("unable to set serial port speed: {}", e));
             port.set_data_bits(DataBits::Eight)
@@ -153,6 +200,10 @@ impl UartBridgeInner {
                 error!("unable to set port duration timeout: {}", e);
             }
 
+            if let Some(scratch_addr) = scratch {
+                Self::negotiate_baud(&mut port, scratch_addr, baud);
+            }
+
             let mut keep_going = true;
             let mut result_error = "".to_owned();
             while keep_going {
@@ -193,6 +244,26 @@ impl UartBridgeInner {
                                 Some(ConnectThreadResponses::PokeResult(result));
                             cvar.notify_one();
                         }
+                        ConnectThreadRequests::BurstRead(addr, len) => {
+                            let result = Self::do_burst_read(&mut port, &mut rx_buf, addr, len);
+                            if let Err(err) = &result {
+                                result_error = format!("burst read {:?} @ {:08x}", err, addr);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstReadResult(result));
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::BurstWrite(addr, data) => {
+                            let result = Self::do_burst_write(&mut port, addr, &data);
+                            if let Err(err) = &result {
+                                result_error = format!("burst write {:?} @ {:08x}", err, addr);
+                                keep_going = false;
+                            }
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::BurstWriteResult(result));
+                            cvar.notify_one();
+                        }
                     },
                 }
             }
@@ -224,6 +295,22 @@ impl UartBridgeInner {
                             ));
                             cvar.notify_one();
                         }
+                        ConnectThreadRequests::BurstRead(_addr, _len) => {
+                            *response.lock().unwrap() = Some(
+                                ConnectThreadResponses::BurstReadResult(Err(
+                                    BridgeError::NotConnected,
+                                )),
+                            );
+                            cvar.notify_one();
+                        }
+                        ConnectThreadRequests::BurstWrite(_addr, _data) => {
+                            *response.lock().unwrap() = Some(
+                                ConnectThreadResponses::BurstWriteResult(Err(
+                                    BridgeError::NotConnected,
+                                )),
+                            );
+                            cvar.notify_one();
+                        }
                         ConnectThreadRequests::StartPolling(p, v) => {
                             path = p.clone();
                             baud = v;
@@ -234,6 +321,95 @@ impl UartBridgeInner {
         }
     }
 
+    /// Ask the USB-serial adapter to flush received data to the host
+    /// after `ms` milliseconds instead of its default (16 ms on FTDI
+    /// parts), which otherwise dominates single-word round trips.  The
+    /// knob lives in sysfs next to the tty device; adapters without it
+    /// are left alone, and a write failure (typically permissions) is
+    /// reported but not fatal.
+    #[cfg(target_os = "linux")]
+    fn set_latency_timer(path: &Path, ms: u8) {
+        let name = match path.file_name().and_then(|n| n.to_str()) {
+            Some(name) => name,
+            None => return,
+        };
+        let sysfs = format!("/sys/bus/usb-serial/devices/{}/latency_timer", name);
+        if !Path::new(&sysfs).exists() {
+            debug!("{} exposes no latency timer, leaving it alone", name);
+            return;
+        }
+        match std::fs::write(&sysfs, format!("{}\n", ms)) {
+            Ok(()) => info!("set {} latency timer to {} ms", name, ms),
+            Err(e) => error!(
+                "unable to set latency timer via {} (may need elevated permissions): {}",
+                sysfs, e
+            ),
+        }
+    }
+
+    #[cfg(not(target_os = "linux"))]
+    fn set_latency_timer(_path: &Path, _ms: u8) {}
+
+    /// Probe the link at each rate in `BAUD_PROFILES`, fastest first,
+    /// and leave the port at the fastest one that reads the scratch
+    /// register back correctly.  A failed probe leaves garbage in the
+    /// receive path, so the port is drained and dropped back to the
+    /// base rate before trying the next profile.
+    fn negotiate_baud(
+        serial: &mut std::boxed::Box<dyn serialport::SerialPort>,
+        scratch_addr: u32,
+        base_baud: u32,
+    ) {
+        let reference = match Self::do_peek(serial, scratch_addr) {
+            Ok(v) => v,
+            Err(e) => {
+                error!("unable to read scratch register, staying at {} baud: {}", base_baud, e);
+                return;
+            }
+        };
+
+        // Probes fail by timing out, so keep the wait short while negotiating.
+        if let Err(e) = serial.set_timeout(Duration::from_millis(200)) {
+            error!("unable to shorten timeout for baud negotiation: {}", e);
+        }
+
+        for &rate in &BAUD_PROFILES {
+            if rate <= base_baud {
+                continue;
+            }
+            if serial.set_baud_rate(rate as _).is_err() {
+                continue;
+            }
+            match Self::do_peek(serial, scratch_addr) {
+                Ok(v) if v == reference => {
+                    info!("negotiated {} baud", rate);
+                    if let Err(e) = serial.set_timeout(Duration::from_millis(1000)) {
+                        error!("unable to restore port timeout: {}", e);
+                    }
+                    return;
+                }
+                _ => {
+                    // Flush whatever the mismatched rate left behind,
+                    // then resynchronize at the base rate.
+                    let mut scrap = [0u8; 256];
+                    while let Ok(n) = serial.read(&mut scrap) {
+                        if n == 0 {
+                            break;
+                        }
+                    }
+                    serial
+                        .set_baud_rate(base_baud as _)
+                        .unwrap_or_else(|e| error!("unable to restore baud rate: {}", e));
+                }
+            }
+        }
+
+        debug!("no faster baud profile usable, staying at {}", base_baud);
+        if let Err(e) = serial.set_timeout(Duration::from_millis(1000)) {
+            error!("unable to restore port timeout: {}", e);
+        }
+    }
+
     pub fn mutex(&self) -> &Arc<Mutex<()>> {
         &self.mutex
     }
@@ -292,6 +468,91 @@ impl UartBridgeInner {
         Ok(val)
     }
 
+    fn do_burst_read(
+        serial: &mut std::boxed::Box<dyn serialport::SerialPort>,
+        rx_buf: &mut Vec<u8>,
+        addr: u32,
+        len: u32,
+    ) -> Result<Vec<u8>, BridgeError> {
+        let mut data = Vec::with_capacity(len as usize);
+        let end = addr.wrapping_add(len);
+        let mut cur = addr & !3;
+        while cur < end {
+            let nwords = ((end - cur + 3) / 4).min(MAX_BURST_WORDS);
+            // READ, `nwords` auto-incrementing words
+            serial.write_all(&[0x02, nwords as u8])?;
+            serial.write_u32::<BigEndian>(cur >> 2)?;
+            serial.flush()?;
+            // Drain the whole response in as few reads as the FIFO
+            // allows rather than issuing a 4-byte read per word.
+            rx_buf.clear();
+            rx_buf.resize(nwords as usize * 4, 0);
+            serial.read_exact(rx_buf)?;
+            for i in 0..nwords as usize {
+                let word = BigEndian::read_u32(&rx_buf[i * 4..i * 4 + 4]).to_le_bytes();
+                for (j, b) in word.iter().enumerate() {
+                    let byte_addr = cur + (i * 4 + j) as u32;
+                    if byte_addr >= addr && byte_addr < end {
+                        data.push(*b);
+                    }
+                }
+            }
+            cur += nwords * 4;
+        }
+        debug!("BURST_READ @ {:08x} ({} bytes)", addr, data.len());
+        Ok(data)
+    }
+
+    fn do_burst_write(
+        serial: &mut std::boxed::Box<dyn serialport::SerialPort>,
+        addr: u32,
+        data: &[u8],
+    ) -> Result<(), BridgeError> {
+        let end = addr.wrapping_add(data.len() as u32);
+        let mut cur = addr & !3;
+        let mut values = Vec::with_capacity(MAX_BURST_WORDS as usize);
+        while cur < end {
+            let nwords = ((end - cur + 3) / 4).min(MAX_BURST_WORDS);
+            // Assemble the chunk up front: partial words at the edges
+            // need a read-modify-write, which must not land in the
+            // middle of the burst command's byte stream.
+            values.clear();
+            for i in 0..nwords {
+                let word_addr = cur + i * 4;
+                let value = if word_addr >= addr && word_addr + 4 <= end {
+                    let offset = (word_addr - addr) as usize;
+                    u32::from_le_bytes([
+                        data[offset],
+                        data[offset + 1],
+                        data[offset + 2],
+                        data[offset + 3],
+                    ])
+                } else {
+                    let mut word = Self::do_peek(serial, word_addr)?.to_le_bytes();
+                    for (j, b) in word.iter_mut().enumerate() {
+                        let byte_addr = word_addr + j as u32;
+                        if byte_addr >= addr && byte_addr < end {
+                            *b = data[(byte_addr - addr) as usize];
+                        }
+                    }
+                    u32::from_le_bytes(word)
+                };
+                values.push(value);
+            }
+
+            // WRITE, `nwords` auto-incrementing words
+            serial.write_all(&[0x01, nwords as u8])?;
+            serial.write_u32::<BigEndian>(cur >> 2)?;
+            for value in &values {
+                serial.write_u32::<BigEndian>(*value)?;
+            }
+            serial.flush()?;
+            cur += nwords * 4;
+        }
+        debug!("BURST_WRITE @ {:08x} ({} bytes)", addr, data.len());
+        Ok(())
+    }
+
     pub fn poke(&self, addr: u32, value: u32) -> Result<(), BridgeError> {
         let &(ref lock, ref cvar) = &*self.main_rx;
         let mut _mtx = lock.lock().unwrap();
@@ -329,6 +590,44 @@ impl UartBridgeInner {
             }
         }
     }
+
+    pub fn burst_read(&self, addr: u32, len: u32) -> Result<Vec<u8>, BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::BurstRead(addr, len))
+            .expect("Unable to send burst read to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::BurstReadResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge burst read response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
+    pub fn burst_write(&self, addr: u32, data: &[u8]) -> Result<(), BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::BurstWrite(addr, data.to_vec()))
+            .expect("Unable to send burst write to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::BurstWriteResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge burst write response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
 }
 
 impl Drop for UartBridgeInner {
@@ -1,3 +1,5 @@
+use std::collections::{HashMap, HashSet};
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::mpsc::{channel, Receiver, Sender, TryRecvError};
 use std::sync::{Arc, Condvar, Mutex};
 use std::thread;
@@ -5,7 +7,7 @@ use std::time::Duration;
 
 use log::{debug, error, info};
 
-use crate::{Bridge, BridgeConfig, BridgeError};
+use crate::{Bridge, BridgeConfig, BridgeError, RawSlice};
 
 /// Connect to a target device via USB.
 #[derive(Clone, Default, Debug)]
@@ -82,6 +84,41 @@ pub struct UsbBridgeInner {
     poll_thread: Option<thread::JoinHandle<()>>,
 }
 
+/// Number of asynchronous control transfers kept in flight during a
+/// burst read on the control path.
+const ASYNC_WINDOW: u32 = 16;
+
+/// Bulk endpoint pair advertised by newer Wishbone-USB gateware.
+/// Bursts are streamed through these instead of being chopped into
+/// control transfers.
+#[derive(Clone, Copy, Debug)]
+struct BulkEndpoints {
+    interface: u8,
+    ep_in: u8,
+    ep_out: u8,
+}
+
+/// Hotplug callback that flags bus topology changes so the poll
+/// thread only re-enumerates when something actually happened. Runs
+/// on the libusb event thread, so it also unparks the poll thread to
+/// cut the reconnect latency to the event-delivery time.
+struct HotplugMonitor {
+    changed: Arc<AtomicBool>,
+    wake: thread::Thread,
+}
+
+impl libusb_wishbone_tool::Hotplug for HotplugMonitor {
+    fn device_arrived(&mut self, _device: libusb_wishbone_tool::Device) {
+        self.changed.store(true, Ordering::Relaxed);
+        self.wake.unpark();
+    }
+
+    fn device_left(&mut self, _device: libusb_wishbone_tool::Device) {
+        self.changed.store(true, Ordering::Relaxed);
+        self.wake.unpark();
+    }
+}
+
 #[derive(Debug)]
 enum ConnectThreadRequests {
     StartPolling(Option<u16> /* vid */, Option<u16> /* pid */),
@@ -89,6 +126,7 @@ enum ConnectThreadRequests {
     Poke(u32 /* addr */, u32 /* val */),
     Peek(u32 /* addr */),
     BurstRead(u32 /* addr */, u32 /* len */),
+    BurstReadInto(u32 /* addr */, RawSlice /* destination */),
     BurstWrite(u32 /* addr */, Vec<u8> /* write data */),
 }
 
@@ -97,6 +135,7 @@ enum ConnectThreadResponses {
     OpenedDevice,
     PeekResult(Result<u32, BridgeError>),
     BurstReadResult(Result<Vec<u8>, BridgeError>),
+    BurstReadIntoResult(Result<(), BridgeError>),
     BurstWriteResult(Result<(), BridgeError>),
     PokeResult(Result<(), BridgeError>),
     Exiting,
@@ -139,16 +178,17 @@ impl UsbBridgeInner {
 
     fn device_matches(
         device: &libusb_wishbone_tool::Device,
-        device_desc: &libusb_wishbone_tool::DeviceDescriptor,
+        device_vid: u16,
+        device_pid: u16,
         cfg: &UsbBridge,
     ) -> bool {
         if let Some(pid) = cfg.pid {
-            if pid != device_desc.product_id() {
+            if pid != device_pid {
                 return false;
             }
         }
         if let Some(vid) = cfg.vid {
-            if vid != device_desc.vendor_id() {
+            if vid != device_vid {
                 return false;
             }
         }
@@ -199,33 +239,144 @@ impl UsbBridgeInner {
     ) {
         let mut print_waiting_message = true;
         let mut first_open = true;
+        // Bus and address of the last device we successfully opened.
+        // Trying it directly first avoids re-reading descriptors for
+        // every device on the bus during reconnect storms.
+        let mut last_match: Option<(u8, u8)> = None;
         let &(ref response, ref cvar) = &*tx;
+
+        // A single dedicated thread services all libusb events for
+        // this context -- transfer completions, transfer timeouts
+        // (delivered through timerfd rather than polling) and hotplug
+        // callbacks -- so nothing here needs to pump events itself.
+        let _event_pump = usb_ctx.event_pump();
+
+        // Prefer hotplug notifications over timed rescans: the kernel
+        // tells us the moment a device arrives or leaves, so while
+        // disconnected we can park instead of re-reading every
+        // descriptor on the bus twice a second. Filtering is left to
+        // device_matches() since the VID/PID can be changed later
+        // through StartPolling.
+        let bus_changed = Arc::new(AtomicBool::new(false));
+        let hotplug_reg = if usb_ctx.has_hotplug() {
+            match usb_ctx.register_callback(
+                None,
+                None,
+                None,
+                Box::new(HotplugMonitor {
+                    changed: bus_changed.clone(),
+                    wake: thread::current(),
+                }),
+            ) {
+                Ok(reg) => Some(reg),
+                Err(e) => {
+                    debug!("unable to register hotplug callback: {:?}", e);
+                    None
+                }
+            }
+        } else {
+            debug!("libusb hotplug support unavailable, falling back to periodic rescan");
+            None
+        };
+
+        // Descriptor reads can be a control transfer each on some
+        // platforms, so cache the VID/PID and the bulk-endpoint layout
+        // per bus/address after the first read. Entries for devices
+        // that have left the bus are dropped below, so a later arrival
+        // reusing the same address starts from a clean slate.
+        let mut desc_cache: HashMap<(u8, u8), (u16, u16)> = HashMap::new();
+        let mut bulk_cache: HashMap<(u8, u8), Option<BulkEndpoints>> = HashMap::new();
+
         loop {
             let devices = usb_ctx.devices().unwrap();
-            for device in devices.iter() {
-                let device_desc = device.device_descriptor().unwrap();
-                if Self::device_matches(&device, &device_desc, &cfg) {
-                    let usb = match device.open() {
-                        Ok(o) => {
-                            info!(
-                                "opened USB device device {:03} on bus {:03}",
-                                device.address(),
-                                device.bus_number()
-                            );
-                            if first_open {
-                                *response.lock().unwrap() =
-                                    Some(ConnectThreadResponses::OpenedDevice);
-                                cvar.notify_one();
-                                first_open = false;
-                            }
-                            print_waiting_message = true;
-                            o
-                        }
-                        Err(e) => {
-                            error!("unable to open usb device: {:?}", e);
-                            continue;
+            let present: HashSet<(u8, u8)> = devices
+                .iter()
+                .map(|d| (d.bus_number(), d.address()))
+                .collect();
+            desc_cache.retain(|key, _| present.contains(key));
+            bulk_cache.retain(|key, _| present.contains(key));
+
+            let mut matched = None;
+            if let Some((bus, address)) = last_match {
+                for device in devices.iter() {
+                    if device.bus_number() == bus && device.address() == address {
+                        matched = Some(device);
+                        break;
+                    }
+                }
+                if matched.is_none() {
+                    debug!("cached device {:03}:{:03} is gone, re-enumerating", bus, address);
+                    last_match = None;
+                }
+            }
+            if matched.is_none() {
+                for device in devices.iter() {
+                    let key = (device.bus_number(), device.address());
+                    let (vid, pid) = match desc_cache.get(&key) {
+                        Some(&ids) => ids,
+                        None => {
+                            let device_desc = device.device_descriptor().unwrap();
+                            let ids = (device_desc.vendor_id(), device_desc.product_id());
+                            desc_cache.insert(key, ids);
+                            ids
                         }
                     };
+                    if Self::device_matches(&device, vid, pid, &cfg) {
+                        matched = Some(device);
+                        break;
+                    }
+                }
+            }
+            let mut had_session = false;
+            if let Some(device) = matched {
+                let opened = match device.open() {
+                    Ok(o) => {
+                        info!(
+                            "opened USB device device {:03} on bus {:03}",
+                            device.address(),
+                            device.bus_number()
+                        );
+                        if first_open {
+                            *response.lock().unwrap() =
+                                Some(ConnectThreadResponses::OpenedDevice);
+                            cvar.notify_one();
+                            first_open = false;
+                        }
+                        print_waiting_message = true;
+                        last_match = Some((device.bus_number(), device.address()));
+                        Some(o)
+                    }
+                    Err(e) => {
+                        error!("unable to open usb device: {:?}", e);
+                        last_match = None;
+                        None
+                    }
+                };
+                if let Some(mut usb) = opened {
+                    had_session = true;
+                    // Negotiate the bulk transport: gateware that
+                    // supports it exposes a vendor-specific interface
+                    // with a bulk IN/OUT pair.  Claiming it may fail
+                    // (e.g. another driver owns it), in which case we
+                    // stay on control transfers.  The endpoint layout
+                    // is cached per bus/address so a reconnect to the
+                    // same device skips straight to claim_interface.
+                    let key = (device.bus_number(), device.address());
+                    let mut bulk = *bulk_cache
+                        .entry(key)
+                        .or_insert_with(|| Self::find_bulk_endpoints(&device));
+                    if let Some(eps) = bulk {
+                        match usb.claim_interface(eps.interface) {
+                            Ok(()) => info!(
+                                "using bulk endpoints {:02x}/{:02x} on interface {}",
+                                eps.ep_in, eps.ep_out, eps.interface
+                            ),
+                            Err(e) => {
+                                debug!("unable to claim bulk interface: {:?}", e);
+                                bulk = None;
+                            }
+                        }
+                    }
                     let mut keep_going = true;
                     while keep_going {
                         let var = rx.recv();
@@ -240,6 +391,9 @@ impl UsbBridgeInner {
                                     return;
                                 }
                                 ConnectThreadRequests::StartPolling(p, v) => {
+                                    if cfg.pid != p || cfg.vid != v {
+                                        last_match = None;
+                                    }
                                     cfg.pid = p;
                                     cfg.vid = v;
                                 }
@@ -258,14 +412,43 @@ impl UsbBridgeInner {
                                     cvar.notify_one();
                                 }
                                 ConnectThreadRequests::BurstRead(addr, len) => {
-                                    let result = Self::do_burst_read(&usb, addr, len, debug_byte);
+                                    let result = Self::do_burst_read(
+                                        &usb_ctx,
+                                        &usb,
+                                        bulk.as_ref(),
+                                        addr,
+                                        len,
+                                        debug_byte,
+                                    );
                                     keep_going = result.is_ok();
                                     *response.lock().unwrap() =
                                         Some(ConnectThreadResponses::BurstReadResult(result));
                                     cvar.notify_one();
                                 }
+                                ConnectThreadRequests::BurstReadInto(addr, buf) => {
+                                    let buf = unsafe { buf.as_mut() };
+                                    let result = Self::do_burst_read_into(
+                                        &usb_ctx,
+                                        &usb,
+                                        bulk.as_ref(),
+                                        addr,
+                                        buf,
+                                        debug_byte,
+                                    );
+                                    keep_going = result.is_ok();
+                                    *response.lock().unwrap() =
+                                        Some(ConnectThreadResponses::BurstReadIntoResult(result));
+                                    cvar.notify_one();
+                                }
                                 ConnectThreadRequests::BurstWrite(addr, data) => {
-                                    let result = Self::do_burst_write(&usb, addr, data, debug_byte);
+                                    let result = Self::do_burst_write(
+                                        &usb_ctx,
+                                        &usb,
+                                        bulk.as_ref(),
+                                        addr,
+                                        data,
+                                        debug_byte,
+                                    );
                                     keep_going = result.is_ok();
                                     *response.lock().unwrap() =
                                         Some(ConnectThreadResponses::BurstWriteResult(result));
@@ -284,55 +467,191 @@ impl UsbBridgeInner {
                 info!("waiting for target device");
                 print_waiting_message = false;
             }
-            thread::park_timeout(Duration::from_millis(500));
 
-            // Respond to any messages in the buffer with NotConnected.  As soon
-            // as the channel is empty, loop back to the start of this function.
+            // Wait for the bus to change before re-enumerating. With
+            // hotplug support the event thread unparks us the moment a
+            // device arrives, so reconnects are near-instant; a rescan
+            // is still forced every 20 slices as a safety net against
+            // missed events. Without hotplug support every slice
+            // triggers a rescan, matching the old 500 ms cadence.
+            // Between slices, queued requests are failed with
+            // NotConnected so clients are never left hanging. A
+            // session that just ended may leave the device attached
+            // with no hotplug event coming, so that case also rescans
+            // after a single slice.
+            let mut wait_slices = 0;
             loop {
-                match rx.try_recv() {
-                    Err(TryRecvError::Empty) => break,
-                    Err(TryRecvError::Disconnected) => panic!("main thread disconnected"),
-                    Ok(m) => match m {
-                        ConnectThreadRequests::Exit => {
-                            debug!("main thread requested exit");
-                            *response.lock().unwrap() = Some(ConnectThreadResponses::Exiting);
-                            cvar.notify_one();
-                            return;
-                        }
-                        ConnectThreadRequests::Peek(_addr) => {
-                            *response.lock().unwrap() = Some(ConnectThreadResponses::PeekResult(
-                                Err(BridgeError::NotConnected),
-                            ));
-                            cvar.notify_one();
-                        }
-                        ConnectThreadRequests::Poke(_addr, _val) => {
-                            *response.lock().unwrap() = Some(ConnectThreadResponses::PokeResult(
-                                Err(BridgeError::NotConnected),
-                            ));
-                            cvar.notify_one();
-                        }
-                        ConnectThreadRequests::StartPolling(p, v) => {
-                            cfg.pid = p;
-                            cfg.vid = v;
-                        }
-                        ConnectThreadRequests::BurstRead(_addr, _len) => {
-                            *response.lock().unwrap() =
-                                Some(ConnectThreadResponses::BurstReadResult(Err(
-                                    BridgeError::NotConnected,
-                                )));
-                            cvar.notify_one();
-                        }
-                        ConnectThreadRequests::BurstWrite(_addr, _data) => {
-                            *response.lock().unwrap() =
-                                Some(ConnectThreadResponses::BurstWriteResult(Err(
-                                    BridgeError::NotConnected,
-                                )));
-                            cvar.notify_one();
-                        }
-                    },
+                thread::park_timeout(Duration::from_millis(500));
+
+                // Respond to any messages in the buffer with NotConnected.  As soon
+                // as the channel is empty, go back to waiting for the device.
+                loop {
+                    match rx.try_recv() {
+                        Err(TryRecvError::Empty) => break,
+                        Err(TryRecvError::Disconnected) => panic!("main thread disconnected"),
+                        Ok(m) => match m {
+                            ConnectThreadRequests::Exit => {
+                                debug!("main thread requested exit");
+                                *response.lock().unwrap() = Some(ConnectThreadResponses::Exiting);
+                                cvar.notify_one();
+                                return;
+                            }
+                            ConnectThreadRequests::Peek(_addr) => {
+                                *response.lock().unwrap() = Some(
+                                    ConnectThreadResponses::PeekResult(Err(
+                                        BridgeError::NotConnected,
+                                    )),
+                                );
+                                cvar.notify_one();
+                            }
+                            ConnectThreadRequests::Poke(_addr, _val) => {
+                                *response.lock().unwrap() = Some(
+                                    ConnectThreadResponses::PokeResult(Err(
+                                        BridgeError::NotConnected,
+                                    )),
+                                );
+                                cvar.notify_one();
+                            }
+                            ConnectThreadRequests::StartPolling(p, v) => {
+                                if cfg.pid != p || cfg.vid != v {
+                                    last_match = None;
+                                }
+                                cfg.pid = p;
+                                cfg.vid = v;
+                            }
+                            ConnectThreadRequests::BurstRead(_addr, _len) => {
+                                *response.lock().unwrap() =
+                                    Some(ConnectThreadResponses::BurstReadResult(Err(
+                                        BridgeError::NotConnected,
+                                    )));
+                                cvar.notify_one();
+                            }
+                            ConnectThreadRequests::BurstReadInto(_addr, _buf) => {
+                                *response.lock().unwrap() =
+                                    Some(ConnectThreadResponses::BurstReadIntoResult(Err(
+                                        BridgeError::NotConnected,
+                                    )));
+                                cvar.notify_one();
+                            }
+                            ConnectThreadRequests::BurstWrite(_addr, _data) => {
+                                *response.lock().unwrap() =
+                                    Some(ConnectThreadResponses::BurstWriteResult(Err(
+                                        BridgeError::NotConnected,
+                                    )));
+                                cvar.notify_one();
+                            }
+                        },
+                    }
+                }
+
+                wait_slices += 1;
+                if hotplug_reg.is_none()
+                    || had_session
+                    || bus_changed.swap(false, Ordering::Relaxed)
+                    || wait_slices >= 20
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Look for a vendor-specific interface carrying a bulk IN/OUT
+    /// endpoint pair.  Returns `None` on older gateware, which only
+    /// has the control endpoint.
+    fn find_bulk_endpoints(device: &libusb_wishbone_tool::Device) -> Option<BulkEndpoints> {
+        let config = device.active_config_descriptor().ok()?;
+        for interface in config.interfaces() {
+            for desc in interface.descriptors() {
+                if desc.class_code() != 0xff {
+                    continue;
+                }
+                let mut ep_in = None;
+                let mut ep_out = None;
+                for ep in desc.endpoint_descriptors() {
+                    if ep.transfer_type() != libusb_wishbone_tool::TransferType::Bulk {
+                        continue;
+                    }
+                    match ep.direction() {
+                        libusb_wishbone_tool::Direction::In => ep_in = Some(ep.address()),
+                        libusb_wishbone_tool::Direction::Out => ep_out = Some(ep.address()),
+                    }
+                }
+                if let (Some(ep_in), Some(ep_out)) = (ep_in, ep_out) {
+                    return Some(BulkEndpoints {
+                        interface: desc.interface_number(),
+                        ep_in,
+                        ep_out,
+                    });
                 }
             }
         }
+        None
+    }
+
+    /// Send a burst command header on the bulk OUT endpoint: the same
+    /// request byte as the control path, followed by the address and
+    /// length as little-endian words.
+    fn send_bulk_command(
+        usb: &libusb_wishbone_tool::DeviceHandle,
+        eps: &BulkEndpoints,
+        request: u8,
+        addr: u32,
+        len: u32,
+    ) -> Result<(), BridgeError> {
+        let mut cmd = [0u8; 12];
+        cmd[0] = request;
+        cmd[4..8].copy_from_slice(&addr.to_le_bytes());
+        cmd[8..12].copy_from_slice(&len.to_le_bytes());
+        let sent = usb.write_bulk(eps.ep_out, &cmd, Duration::from_millis(500))?;
+        if sent != cmd.len() {
+            return Err(BridgeError::LengthError(cmd.len(), sent));
+        }
+        Ok(())
+    }
+
+    fn do_bulk_burst_read(
+        usb: &libusb_wishbone_tool::DeviceHandle,
+        eps: &BulkEndpoints,
+        addr: u32,
+        buf: &mut [u8],
+        debug_byte: u8,
+    ) -> Result<(), BridgeError> {
+        Self::send_bulk_command(usb, eps, 0x80 | debug_byte, addr, buf.len() as u32)?;
+        let mut received = 0;
+        while received < buf.len() {
+            match usb.read_bulk(eps.ep_in, &mut buf[received..], Duration::from_millis(500)) {
+                Err(e) => {
+                    debug!("BULK_READ @ {:08x}: usb error {:?}", addr, e);
+                    return Err(BridgeError::USBError(e));
+                }
+                Ok(0) => return Err(BridgeError::LengthError(buf.len(), received)),
+                Ok(n) => received += n,
+            }
+        }
+        Ok(())
+    }
+
+    fn do_bulk_burst_write(
+        usb: &libusb_wishbone_tool::DeviceHandle,
+        eps: &BulkEndpoints,
+        addr: u32,
+        data: &[u8],
+        debug_byte: u8,
+    ) -> Result<(), BridgeError> {
+        Self::send_bulk_command(usb, eps, debug_byte, addr, data.len() as u32)?;
+        let mut sent = 0;
+        while sent < data.len() {
+            match usb.write_bulk(eps.ep_out, &data[sent..], Duration::from_millis(500)) {
+                Err(e) => {
+                    debug!("BULK_WRITE @ {:08x}: usb error {:?}", addr, e);
+                    return Err(BridgeError::USBError(e));
+                }
+                Ok(0) => return Err(BridgeError::LengthError(data.len(), sent)),
+                Ok(n) => sent += n,
+            }
+        }
+        Ok(())
     }
 
     fn do_poke(
@@ -374,7 +693,9 @@ impl UsbBridgeInner {
     }
 
     fn do_burst_write(
+        ctx: &libusb_wishbone_tool::Context,
         usb: &libusb_wishbone_tool::DeviceHandle,
+        bulk: Option<&BulkEndpoints>,
         addr: u32,
         data: Vec<u8>,
         debug_byte: u8,
@@ -383,42 +704,56 @@ impl UsbBridgeInner {
             return Ok(());
         }
 
+        if let Some(eps) = bulk {
+            return Self::do_bulk_burst_write(usb, eps, addr, &data, debug_byte);
+        }
+
         let maxlen = 4096; // spec says...1023 max? but 4096 works.
 
-        let packet_count = data.len() / maxlen + if (data.len() % maxlen) != 0 { 1 } else { 0 };
-        for pkt_num in 0..packet_count {
-            let cur_addr = addr as usize + pkt_num * maxlen;
-            let bufsize = if pkt_num == (packet_count - 1) {
-                if data.len() % maxlen != 0 {
-                    data.len() % maxlen
-                } else {
-                    maxlen
-                }
-            } else {
-                maxlen
-            };
-            match usb.write_control(
+        // Mirror of do_burst_read_into(): each chunk of the source
+        // buffer becomes one control transfer, and a window of
+        // transfers is submitted together so the fixed per-transfer
+        // cost is paid once per batch rather than once per chunk.
+        let chunk_slices: Vec<&[u8]> = data.chunks(maxlen).collect();
+        let packet_count = chunk_slices.len();
+        let mut pkt_num = 0;
+        while pkt_num < packet_count {
+            let window = (packet_count - pkt_num).min(ASYNC_WINDOW as usize);
+            let mut chunks: Vec<(u16, u16, &[u8])> = Vec::with_capacity(window);
+            for (i, slice) in chunk_slices[pkt_num..pkt_num + window].iter().enumerate() {
+                let cur_addr = addr as usize + (pkt_num + i) * maxlen;
+                chunks.push((
+                    (cur_addr & 0xffff) as u16,
+                    ((cur_addr >> 16) & 0xffff) as u16,
+                    slice,
+                ));
+            }
+            match usb.write_control_batch(
+                ctx,
                 debug_byte,
                 0,
-                (cur_addr & 0xffff) as u16,
-                ((cur_addr >> 16) & 0xffff) as u16,
-                &data[pkt_num * maxlen..pkt_num * maxlen + bufsize],
+                &chunks,
                 Duration::from_millis(500),
             ) {
                 Err(e) => {
                     debug!("BURST_WRITE @ {:08x}: usb error {:?}", addr, e);
                     return Err(BridgeError::USBError(e));
                 }
-                Ok(retlen) => {
-                    if retlen != bufsize as usize {
-                        debug!(
-                            "BURST_WRITE @ {:08x}: length error: expected {} bytes, got {} bytes",
-                            addr, bufsize, retlen
-                        );
-                        return Err(BridgeError::LengthError(bufsize as usize, retlen));
+                Ok(lengths) => {
+                    for (i, (_value, _index, chunk)) in chunks.iter().enumerate() {
+                        if lengths[i] != chunk.len() {
+                            debug!(
+                                "BURST_WRITE @ {:08x}: length error: expected {} bytes, got {} bytes",
+                                addr,
+                                chunk.len(),
+                                lengths[i]
+                            );
+                            return Err(BridgeError::LengthError(chunk.len(), lengths[i]));
+                        }
                     }
                 }
             }
+            pkt_num += window;
         }
         Ok(())
     }
@@ -461,64 +796,82 @@ impl UsbBridgeInner {
     }
 
     fn do_burst_read(
+        ctx: &libusb_wishbone_tool::Context,
         usb: &libusb_wishbone_tool::DeviceHandle,
+        bulk: Option<&BulkEndpoints>,
         addr: u32,
         len: u32,
         debug_byte: u8,
     ) -> Result<Vec<u8>, BridgeError> {
-        let mut data_val = vec![];
+        let mut data_val = vec![0; len as usize];
+        Self::do_burst_read_into(ctx, usb, bulk, addr, &mut data_val, debug_byte)?;
+        Ok(data_val)
+    }
 
-        if len == 0 {
-            return Ok(data_val);
+    fn do_burst_read_into(
+        ctx: &libusb_wishbone_tool::Context,
+        usb: &libusb_wishbone_tool::DeviceHandle,
+        bulk: Option<&BulkEndpoints>,
+        addr: u32,
+        buf: &mut [u8],
+        debug_byte: u8,
+    ) -> Result<(), BridgeError> {
+        if buf.is_empty() {
+            return Ok(());
+        }
+
+        if let Some(eps) = bulk {
+            return Self::do_bulk_burst_read(usb, eps, addr, buf, debug_byte);
         }
 
         let maxlen = 4096; // spec says...1023 max? but 4096 works.
 
-        let packet_count = len / maxlen + if (len % maxlen) != 0 { 1 } else { 0 };
-        for pkt_num in 0..packet_count {
-            let cur_addr = addr + pkt_num * maxlen;
-            let bufsize = if pkt_num == (packet_count - 1) {
-                if len % maxlen != 0 {
-                    len % maxlen
-                } else {
-                    maxlen
-                }
-            } else {
-                maxlen
-            };
-            let mut buffer = vec![0; bufsize as usize];
-            match usb.read_control(
+        // Each chunk of the destination buffer becomes one control
+        // transfer, completed in place with no intermediate copy.  A
+        // window of transfers stays in flight so the device works on
+        // one chunk while the host reaps the previous one.
+        let mut chunk_slices: Vec<&mut [u8]> = buf.chunks_mut(maxlen).collect();
+        let packet_count = chunk_slices.len();
+        let mut pkt_num = 0;
+        while pkt_num < packet_count {
+            let window = (packet_count - pkt_num).min(ASYNC_WINDOW as usize);
+            let mut chunks: Vec<(u16, u16, &mut [u8])> = Vec::with_capacity(window);
+            for (i, slice) in chunk_slices[pkt_num..pkt_num + window].iter_mut().enumerate() {
+                let cur_addr = addr as usize + (pkt_num + i) * maxlen;
+                chunks.push((
+                    (cur_addr & 0xffff) as u16,
+                    ((cur_addr >> 16) & 0xffff) as u16,
+                    slice,
+                ));
+            }
+            match usb.read_control_batch(
+                ctx,
                 0x80 | debug_byte,
                 0,
-                (cur_addr & 0xffff) as u16,
-                ((cur_addr >> 16) & 0xffff) as u16,
-                &mut buffer,
+                &mut chunks,
                 Duration::from_millis(500),
             ) {
                 Err(e) => {
                     debug!("BURST_READ @ {:08x}: usb error {:?}", addr, e);
                     return Err(BridgeError::USBError(e));
                 }
-                Ok(retlen) => {
-                    if retlen != bufsize as usize {
-                        debug!(
-                            "BURST_READ @ {:08x}: length error: expected {} bytes, got {} bytes",
-                            addr, bufsize, retlen
-                        );
-                        return Err(BridgeError::LengthError(bufsize as usize, retlen));
-                    } else {
-                        for i in 0..data_val.len() {
-                            if (i % 16) == 0 {
-                                debug!("\nBURST_READ @ {:08x}: ", addr as usize + i);
-                            }
-                            debug!("{:02x} ", data_val[i]);
+                Ok(lengths) => {
+                    for (i, (_value, _index, chunk)) in chunks.iter().enumerate() {
+                        if lengths[i] != chunk.len() {
+                            debug!(
+                                "BURST_READ @ {:08x}: length error: expected {} bytes, got {} bytes",
+                                addr,
+                                chunk.len(),
+                                lengths[i]
+                            );
+                            return Err(BridgeError::LengthError(chunk.len(), lengths[i]));
                         }
-                        data_val.append(&mut buffer);
                     }
                 }
             }
+            pkt_num += window;
         }
-        Ok(data_val)
+        Ok(())
     }
 
     pub fn poke(&self, addr: u32, value: u32) -> Result<(), BridgeError> {
@@ -578,6 +931,25 @@ impl UsbBridgeInner {
         }
     }
 
+    pub fn burst_read_into(&self, addr: u32, buf: &mut [u8]) -> Result<(), BridgeError> {
+        let &(ref lock, ref cvar) = &*self.main_rx;
+        let mut _mtx = lock.lock().unwrap();
+        self.main_tx
+            .send(ConnectThreadRequests::BurstReadInto(addr, RawSlice::new(buf)))
+            .expect("Unable to send burst read to connect thread");
+        *_mtx = None;
+        while _mtx.is_none() {
+            _mtx = cvar.wait(_mtx).unwrap();
+        }
+        match _mtx.take() {
+            Some(ConnectThreadResponses::BurstReadIntoResult(r)) => Ok(r?),
+            e => {
+                error!("unexpected bridge burst read response: {:?}", e);
+                Err(BridgeError::WrongResponse)
+            }
+        }
+    }
+
     pub fn burst_write(&self, addr: u32, data: &[u8]) -> Result<(), BridgeError> {
         let &(ref lock, ref cvar) = &*self.main_rx;
         let mut _mtx = lock.lock().unwrap();
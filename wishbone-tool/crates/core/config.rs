@@ -8,6 +8,9 @@ use wishbone_bridge::{
     Bridge, EthernetBridge, EthernetBridgeProtocol, PCIeBridge, SpiBridge, UartBridge, UsbBridge,
 };
 
+/// Magic and format version of the parsed-register-map sidecar cache.
+const CSR_CACHE_MAGIC: &[u8; 8] = b"WBCSRM01";
+
 #[derive(Debug)]
 pub enum ConfigError {
     /// Couldn't parse string as number
@@ -92,11 +95,18 @@ pub struct Config {
     pub server_kind: Vec<ServerKind>,
     pub bind_addr: String,
     pub bind_port: u16,
+    pub wishbone_udp: bool,
     pub gdb_port: u16,
     pub random_loops: Option<u32>,
     pub random_address: Option<u32>,
     pub random_range: Option<u32>,
     pub messible_address: Option<u32>,
+    pub snapshot_address: Option<u32>,
+    pub snapshot_length: u32,
+    pub snapshot_path: Option<String>,
+    pub snapshot_interval_ms: u64,
+    pub record_traffic: Option<String>,
+    pub replay_trace: Option<String>,
 
     /// A mapping of CSR names to translated register offsets. If an
     /// address is a valid CSR but cannot be mapped due to the Wishbone
@@ -106,12 +116,15 @@ pub struct Config {
     pub load_name: Option<String>,
     pub load_addr: Option<u32>,
     pub load_flash: bool,
+    pub load_sparse: bool,
     pub terminal_mouse: bool,
     pub burst_length: u32,
     pub hexdump: bool,
     pub burst_source: Option<String>,
+    pub burst_dest: Option<String>,
     pub flash_no_reset: bool,
     pub careful_flashing: bool,
+    pub incremental_flashing: bool,
 }
 
 impl Default for Config {
@@ -122,28 +135,127 @@ impl Default for Config {
             server_kind: vec![],
             bind_addr: "127.0.0.1".to_owned(),
             bind_port: 1234,
+            wishbone_udp: false,
             gdb_port: 3333,
             random_loops: None,
             random_address: None,
             random_range: None,
             messible_address: None,
+            snapshot_address: None,
+            snapshot_length: 256,
+            snapshot_path: None,
+            snapshot_interval_ms: 10,
+            record_traffic: None,
+            replay_trace: None,
             register_mapping: HashMap::new(),
             debug_offset: 0,
             load_name: None,
             load_addr: None,
             load_flash: false,
+            load_sparse: false,
             terminal_mouse: false,
             burst_length: 4,
             hexdump: false,
             burst_source: None,
+            burst_dest: None,
             flash_no_reset: false,
             careful_flashing: false,
+            incremental_flashing: false,
         }
     }
 }
 
 impl Config {
+    fn create_uart_bridge(matches: &ArgMatches) -> Result<Bridge, ConfigError> {
+        let port = matches.value_of("serial").unwrap();
+        // Strip off the trailing ":" on Windows, since it's confusing
+        let serial_port = if cfg!(windows) && port.ends_with(':') {
+            port.get(0..port.len() - 1).unwrap_or("")
+        } else {
+            port
+        };
+        let mut uart_config = UartBridge::new(serial_port).or_else(|e| {
+            Err(ConfigError::InvalidConfig(format!(
+                "invalid serial port: {}",
+                e
+            )))
+        })?;
+
+        if let Some(baud) = matches.value_of("baud") {
+            uart_config.baud(parse_u32(baud)?);
+        }
+
+        if let Some(ms) = matches.value_of("latency-timer") {
+            uart_config.latency_timer(parse_u32(ms)?.min(255) as u8);
+        }
+
+        uart_config
+            .create()
+            .map_err(|e| ConfigError::InvalidConfig(format!("unable to create uart bridge: {}", e)))
+    }
+
+    fn create_ethernet_bridge(matches: &ArgMatches) -> Result<Bridge, ConfigError> {
+        let host = matches.value_of("ethernet-host").unwrap();
+        let ethernet_tcp = matches.is_present("ethernet-tcp");
+        let ethernet_port = parse_u16(matches.value_of("ethernet-port").unwrap())?;
+        let mut ebc = EthernetBridge::new(host)
+            .or_else(|_| EthernetBridge::new(&format!("{}:{}", host, ethernet_port)))
+            .or_else(|e| {
+                Err(ConfigError::InvalidConfig(format!(
+                    "invalid ethernet address: {}",
+                    e
+                )))
+            })?;
+        ebc.protocol(if ethernet_tcp {
+            EthernetBridgeProtocol::TCP
+        } else {
+            EthernetBridgeProtocol::UDP
+        })
+        .port(ethernet_port);
+        ebc.create().map_err(|e| {
+            ConfigError::InvalidConfig(format!("unable to create ethernet bridge: {}", e))
+        })
+    }
+
+    fn create_usb_bridge(matches: &ArgMatches) -> Result<Bridge, ConfigError> {
+        let mut usb_config = UsbBridge::new();
+        if let Some(vid) = matches.value_of("vid") {
+            usb_config.vid(parse_u16(vid)?);
+        }
+        if let Some(pid) = matches.value_of("pid") {
+            usb_config.pid(parse_u16(pid)?);
+        }
+        if let Some(bus) = matches.value_of("bus") {
+            usb_config.bus(parse_u8(bus)?);
+        }
+        if let Some(device) = matches.value_of("device") {
+            usb_config.device(parse_u8(device)?);
+        }
+        usb_config
+            .create()
+            .map_err(|e| ConfigError::InvalidConfig(format!("unable to create usb bridge: {}", e)))
+    }
+
     fn create_bridge(matches: &ArgMatches) -> Result<Bridge, ConfigError> {
+        // With `--auto-probe`, race every plausible backend and commit
+        // to the first one that answers a scratch-register read.  The
+        // attach time becomes the fastest probe rather than a guess at
+        // the right backend followed by a long blocking connect.
+        if matches.is_present("auto-probe") {
+            let mut candidates = vec![];
+            if matches.value_of("serial").is_some() {
+                candidates.push(Self::create_uart_bridge(matches)?);
+            }
+            if matches.value_of("ethernet-host").is_some() {
+                candidates.push(Self::create_ethernet_bridge(matches)?);
+            }
+            // USB needs no configuration, so it is always a candidate.
+            candidates.push(Self::create_usb_bridge(matches)?);
+            return Bridge::probe_first(candidates, 0).map_err(|e| {
+                ConfigError::InvalidConfig(format!("no probed bridge answered: {}", e))
+            });
+        }
+
         // If SPI pins are specified, then assume the bridge must be SPI.
         if let Some(pins) = matches.value_of("spi-pins") {
             return SpiBridge::new(pins)
@@ -155,27 +267,8 @@ impl Config {
         }
 
         // UART bridge config
-        if let Some(port) = matches.value_of("serial") {
-            // Strip off the trailing ":" on Windows, since it's confusing
-            let serial_port = if cfg!(windows) && port.ends_with(':') {
-                port.get(0..port.len() - 1).unwrap_or("")
-            } else {
-                port
-            };
-            let mut uart_config = UartBridge::new(serial_port).or_else(|e| {
-                Err(ConfigError::InvalidConfig(format!(
-                    "invalid serial port: {}",
-                    e
-                )))
-            })?;
-
-            if let Some(baud) = matches.value_of("baud") {
-                uart_config.baud(parse_u32(baud)?);
-            }
-
-            return uart_config.create().map_err(|e| {
-                ConfigError::InvalidConfig(format!("unable to create uart bridge: {}", e))
-            });
+        if matches.value_of("serial").is_some() {
+            return Self::create_uart_bridge(matches);
         }
 
         // PCIe BAR-as-a-file
@@ -194,45 +287,12 @@ impl Config {
         }
 
         // Ethernet (TCP or UDP)
-        if let Some(host) = matches.value_of("ethernet-host") {
-            let ethernet_tcp = matches.is_present("ethernet-tcp");
-            let ethernet_port = parse_u16(matches.value_of("ethernet-port").unwrap())?;
-            let mut ebc = EthernetBridge::new(host)
-                .or_else(|_| EthernetBridge::new(&format!("{}:{}", host, ethernet_port)))
-                .or_else(|e| {
-                    Err(ConfigError::InvalidConfig(format!(
-                        "invalid ethernet address: {}",
-                        e
-                    )))
-                })?;
-            ebc.protocol(if ethernet_tcp {
-                EthernetBridgeProtocol::TCP
-            } else {
-                EthernetBridgeProtocol::UDP
-            })
-            .port(ethernet_port);
-            return ebc.create().map_err(|e| {
-                ConfigError::InvalidConfig(format!("unable to create ethernet bridge: {}", e))
-            });
+        if matches.value_of("ethernet-host").is_some() {
+            return Self::create_ethernet_bridge(matches);
         }
 
         // Fall back to USB
-        let mut usb_config = UsbBridge::new();
-        if let Some(vid) = matches.value_of("vid") {
-            usb_config.vid(parse_u16(vid)?);
-        }
-        if let Some(pid) = matches.value_of("pid") {
-            usb_config.pid(parse_u16(pid)?);
-        }
-        if let Some(bus) = matches.value_of("bus") {
-            usb_config.bus(parse_u8(bus)?);
-        }
-        if let Some(device) = matches.value_of("device") {
-            usb_config.device(parse_u8(device)?);
-        }
-        usb_config
-            .create()
-            .map_err(|e| ConfigError::InvalidConfig(format!("unable to create usb bridge: {}", e)))
+        Self::create_usb_bridge(matches)
     }
 
     pub fn parse(matches: ArgMatches) -> Result<(Self, Bridge), ConfigError> {
@@ -240,6 +300,7 @@ impl Config {
 
         let load_name = matches.value_of("load-name").map(|n| n.to_owned());
         let load_flash = matches.is_present("load-flash");
+        let load_sparse = matches.is_present("load-sparse");
         let load_addr = if let Some(addr) = matches.value_of("load-address") {
             if load_name.is_none() & !load_flash {
                 server_kind.push(ServerKind::MemoryAccess);
@@ -260,6 +321,7 @@ impl Config {
         // unwrap() is safe because there is a default value
         let gdb_port = parse_u16(matches.value_of("gdb-port").unwrap())?;
         let bind_port = parse_u16(matches.value_of("wishbone-port").unwrap())?;
+        let wishbone_udp = matches.is_present("wishbone-udp");
         let burst_length = parse_u32(matches.value_of("burst-length").unwrap())?;
 
         let bind_addr = matches
@@ -308,6 +370,25 @@ impl Config {
             None
         };
 
+        let snapshot_address = if let Some(snapshot_address) = matches.value_of("snapshot-address")
+        {
+            Some(
+                parse_u32_address(snapshot_address, offset)?
+                    .ok_or_else(|| ConfigError::AddressOutOfRange(snapshot_address.to_owned()))?,
+            )
+        } else {
+            None
+        };
+
+        // unwrap() is safe because there are default values
+        let snapshot_length = parse_u32(matches.value_of("snapshot-length").unwrap())?;
+        let snapshot_interval_ms =
+            u64::from(parse_u32(matches.value_of("snapshot-interval").unwrap())?);
+        let snapshot_path = matches.value_of("snapshot-path").map(|n| n.to_owned());
+
+        let record_traffic = matches.value_of("record-traffic").map(|n| n.to_owned());
+        let replay_trace = matches.value_of("replay-trace").map(|n| n.to_owned());
+
         let debug_offset = if let Some(debug_offset) = matches.value_of("debug-offset") {
             parse_u32_address(debug_offset, offset)?
                 .ok_or_else(|| ConfigError::AddressOutOfRange(debug_offset.to_owned()))?
@@ -373,12 +454,26 @@ impl Config {
             }
         }
 
+        if server_kind.contains(&ServerKind::Snapshot) && snapshot_address.is_none() {
+            return Err(ConfigError::InvalidConfig(
+                "snapshot server requested, but no --snapshot-address given".to_owned(),
+            ));
+        }
+
+        if server_kind.contains(&ServerKind::Replay) && replay_trace.is_none() {
+            return Err(ConfigError::InvalidConfig(
+                "trace replay requested, but no --replay-trace given".to_owned(),
+            ));
+        }
+
         let terminal_mouse = matches.is_present("terminal-mouse") || cfg!(windows);
         let hexdump = matches.is_present("hexdump");
         let flash_no_reset = matches.is_present("flash-no-reset");
         let careful_flashing = matches.is_present("careful-flashing");
+        let incremental_flashing = matches.is_present("incremental-flashing");
 
         let burst_source = matches.value_of("burst-source").map(|n| n.to_owned());
+        let burst_dest = matches.value_of("burst-dest").map(|n| n.to_owned());
 
         let bridge = Self::create_bridge(&matches)?;
 
@@ -389,44 +484,112 @@ impl Config {
                 server_kind,
                 bind_port,
                 bind_addr,
+                wishbone_udp,
                 gdb_port,
                 random_loops,
                 random_address,
                 random_range,
                 messible_address,
+                snapshot_address,
+                snapshot_length,
+                snapshot_path,
+                snapshot_interval_ms,
+                record_traffic,
+                replay_trace,
                 register_mapping,
                 debug_offset,
                 load_name,
                 load_addr,
                 load_flash,
+                load_sparse,
                 terminal_mouse,
                 burst_length,
                 hexdump,
                 burst_source,
+                burst_dest,
                 flash_no_reset,
                 careful_flashing,
+                incremental_flashing,
             },
             bridge,
         ))
     }
 
-    fn parse_csr_csv(
-        filename: Option<&str>,
-        offset_str: Option<&str>,
-    ) -> Result<(HashMap<String, Option<u32>>, u32), ConfigError> {
-        let mut map = HashMap::new();
-        let file = match filename {
-            None => {
-                if let Some(offset_str) = offset_str {
-                    return Ok((map, parse_u32(offset_str)?));
-                } else {
-                    return Ok((map, 0));
-                }
-            }
-            Some(s) => File::open(s)?,
+    /// The stat fingerprint a register-map cache file is keyed by:
+    /// the CSV's length, modification time in seconds, and nanoseconds.
+    fn csr_csv_stamp(filename: &str) -> Option<(u64, u64, u64)> {
+        let meta = std::fs::metadata(filename).ok()?;
+        let mtime = meta
+            .modified()
+            .ok()?
+            .duration_since(std::time::UNIX_EPOCH)
+            .ok()?;
+        Some((meta.len(), mtime.as_secs(), u64::from(mtime.subsec_nanos())))
+    }
+
+    fn csr_cache_path(filename: &str) -> std::path::PathBuf {
+        std::path::PathBuf::from(format!("{}.cache", filename))
+    }
+
+    /// Try to load the parsed register map from the binary sidecar
+    /// file next to the CSV.  Returns None -- falling back to the CSV
+    /// parser -- if the cache is missing, stale, or malformed.
+    fn load_csr_cache(filename: &str) -> Option<HashMap<String, u32>> {
+        let stamp = Self::csr_csv_stamp(filename)?;
+        let data = std::fs::read(Self::csr_cache_path(filename)).ok()?;
+
+        let mut pos = 0;
+        let mut take = |len: usize| -> Option<&[u8]> {
+            let field = data.get(pos..pos + len)?;
+            pos += len;
+            Some(field)
         };
+        use std::convert::TryInto;
 
-        let mut offset = 0;
+        if take(8)? != CSR_CACHE_MAGIC {
+            return None;
+        }
+        let mut take_u64 = || Some(u64::from_le_bytes(take(8)?.try_into().ok()?));
+        if (take_u64()?, take_u64()?, take_u64()?) != stamp {
+            return None;
+        }
+
+        let count = u64::from_le_bytes(take(8)?.try_into().ok()?);
+        let mut map = HashMap::with_capacity(count as usize);
+        for _ in 0..count {
+            let name_len = u16::from_le_bytes(take(2)?.try_into().ok()?) as usize;
+            let name = String::from_utf8(take(name_len)?.to_vec()).ok()?;
+            let addr = u32::from_le_bytes(take(4)?.try_into().ok()?);
+            map.insert(name, addr);
+        }
+        Some(map)
+    }
+
+    /// Write the binary sidecar cache.  Best effort: a read-only
+    /// directory just means the next run parses the CSV again.
+    fn store_csr_cache(filename: &str, map: &HashMap<String, u32>) {
+        let stamp = match Self::csr_csv_stamp(filename) {
+            Some(s) => s,
+            None => return,
+        };
+        let mut out = Vec::with_capacity(32 + map.len() * 24);
+        out.extend_from_slice(CSR_CACHE_MAGIC);
+        out.extend_from_slice(&stamp.0.to_le_bytes());
+        out.extend_from_slice(&stamp.1.to_le_bytes());
+        out.extend_from_slice(&stamp.2.to_le_bytes());
+        out.extend_from_slice(&(map.len() as u64).to_le_bytes());
+        for (name, addr) in map {
+            out.extend_from_slice(&(name.len() as u16).to_le_bytes());
+            out.extend_from_slice(name.as_bytes());
+            out.extend_from_slice(&addr.to_le_bytes());
+        }
+        let _ = std::fs::write(Self::csr_cache_path(filename), out);
+    }
+
+    /// Parse the register map out of a csr.csv file.
+    fn parse_csr_csv_file(filename: &str) -> Result<HashMap<String, u32>, ConfigError> {
+        let mut map = HashMap::new();
+        let file = File::open(filename)?;
 
         let mut rdr = csv::ReaderBuilder::new().flexible(true).from_reader(file);
         for result in rdr.records() {
@@ -442,10 +605,10 @@ impl Config {
                         // If this is the case, create indexed offsets for those registers.
                         match num_regs {
                             1 => {
-                                map.insert(reg_name.to_string().to_lowercase(), Some(base_addr));
+                                map.insert(reg_name.to_string().to_lowercase(), base_addr);
                             }
                             n => {
-                                map.insert(reg_name.to_string().to_lowercase(), Some(base_addr));
+                                map.insert(reg_name.to_string().to_lowercase(), base_addr);
                                 for logical_reg in 0..n {
                                     map.insert(
                                         format!(
@@ -453,7 +616,7 @@ impl Config {
                                             reg_name.to_string().to_lowercase(),
                                             n - logical_reg - 1
                                         ),
-                                        Some(base_addr + logical_reg * 4),
+                                        base_addr + logical_reg * 4,
                                     );
                                 }
                             }
@@ -462,17 +625,51 @@ impl Config {
                     "memory_region" => {
                         let region = &r[1];
                         let base_addr = parse_u32(&r[2])?;
-                        map.insert(region.to_string().to_lowercase(), Some(base_addr));
+                        map.insert(region.to_string().to_lowercase(), base_addr);
                     }
                     "csr_base" => {
                         let region = &r[1];
                         let base_addr = parse_u32(&r[2])?;
-                        map.insert(region.to_string().to_lowercase(), Some(base_addr));
+                        map.insert(region.to_string().to_lowercase(), base_addr);
                     }
                     _ => (),
                 };
             }
         }
+        Ok(map)
+    }
+
+    fn parse_csr_csv(
+        filename: Option<&str>,
+        offset_str: Option<&str>,
+    ) -> Result<(HashMap<String, Option<u32>>, u32), ConfigError> {
+        let filename = match filename {
+            None => {
+                if let Some(offset_str) = offset_str {
+                    return Ok((HashMap::new(), parse_u32(offset_str)?));
+                } else {
+                    return Ok((HashMap::new(), 0));
+                }
+            }
+            Some(s) => s,
+        };
+
+        let mut offset = 0;
+
+        // Large SoCs ship csr.csv files tens of thousands of lines
+        // long; load the map from the binary sidecar cache when its
+        // fingerprint still matches, and (re)write the cache after any
+        // full parse.
+        let raw = match Self::load_csr_cache(filename) {
+            Some(map) => map,
+            None => {
+                let map = Self::parse_csr_csv_file(filename)?;
+                Self::store_csr_cache(filename, &map);
+                map
+            }
+        };
+        let mut map: HashMap<String, Option<u32>> =
+            raw.into_iter().map(|(k, v)| (k, Some(v))).collect();
 
         // Now that we have everything loaded into the hashmap, see if we need to offset values.
         if let Some(offset_str) = offset_str {
@@ -9,7 +9,7 @@ use wishbone_bridge::{Bridge, BridgeError};
 use log::{debug, error, info};
 
 use crate::gdb::byteorder::ByteOrder;
-use byteorder::{BigEndian, NativeEndian};
+use byteorder::{BigEndian, LittleEndian, NativeEndian};
 
 const SUPPORTED_QUERIES: &[u8] = b"PacketSize=3fff;qXfer:features:read+;qXfer:threads:read+;qXfer:memory-map:read-;QStartNoAckMode+;vContSupported+";
 
@@ -65,6 +65,14 @@ impl GdbController {
 
 pub struct GdbServer {
     connection: TcpStream,
+
+    /// Buffered view of the same socket, so packet bytes don't cost a
+    /// syscall each.
+    reader: io::BufReader<TcpStream>,
+
+    /// Persistent packet buffer, reused for every inbound packet so a
+    /// running GDB session doesn't exercise the allocator per command.
+    pkt_buffer: Vec<u8>,
     no_ack_mode: bool,
     is_alive: bool,
     last_signal: u8,
@@ -91,16 +99,22 @@ pub fn parse_i32(value: &str) -> Result<i32, GdbServerError> {
     }
 }
 
-fn gdb_unescape(input: &[u8]) -> Vec<u8> {
-    let mut it = input.iter();
-    let mut out = Vec::new();
-    while let Some(c) = it.next() {
-        if *c == b'}' {
-            if let Some(c) = it.next() {
-                out.push(*c ^ 0x20);
+/// Undo GDB's binary escaping in place, returning the unescaped
+/// length.  The data only ever shrinks, so no scratch buffer is needed.
+fn gdb_unescape_in_place(data: &mut [u8]) -> usize {
+    let mut out = 0;
+    let mut i = 0;
+    while i < data.len() {
+        if data[i] == b'}' {
+            if i + 1 < data.len() {
+                data[out] = data[i + 1] ^ 0x20;
+                out += 1;
             }
+            i += 2;
         } else {
-            out.push(*c);
+            data[out] = data[i];
+            out += 1;
+            i += 1;
         }
     }
     out
@@ -235,6 +249,13 @@ pub enum GdbCommand {
         Vec<u32>, /* value */
     ),
 
+    /// X#,#:binary -- raw target bytes in address order
+    WriteMemoryBinary(
+        u32,     /* addr */
+        u32,     /* length */
+        Vec<u8>, /* data */
+    ),
+
     /// vCont?
     VContQuery,
 
@@ -244,6 +265,9 @@ pub enum GdbCommand {
     /// vCont;C04:0;c
     VContContinueFromSignal(String),
 
+    /// vCont;rSTART,END -- step while the pc stays inside [START, END)
+    VContRangeStep(u32 /* start */, u32 /* end */),
+
     /// vCont;s:0;c
     VContStepFromSignal(String),
 
@@ -295,8 +319,11 @@ pub enum GdbCommand {
 
 impl GdbServer {
     pub fn new(connection: TcpStream) -> Result<GdbServer, GdbServerError> {
+        let reader = io::BufReader::new(connection.try_clone()?);
         Ok(GdbServer {
             connection,
+            reader,
+            pkt_buffer: Vec::with_capacity(16384),
             no_ack_mode: false,
             is_alive: true,
             last_signal: 0,
@@ -304,7 +331,7 @@ impl GdbServer {
     }
 
     #[allow(clippy::cognitive_complexity)]
-    fn packet_to_command(&self, raw_pkt: &[u8]) -> Result<GdbCommand, GdbServerError> {
+    fn packet_to_command(&self, raw_pkt: &mut [u8]) -> Result<GdbCommand, GdbServerError> {
         let pkt = String::from_utf8_lossy(raw_pkt).to_string();
         debug!("Raw GDB packet: {}", pkt);
 
@@ -381,7 +408,7 @@ impl GdbServer {
         } else if pkt == "g" {
             Ok(GdbCommand::GetRegisters)
         } else if pkt.starts_with('P') {
-            let pkt = pkt.trim_start_matches('P').to_string();
+            let pkt = pkt.trim_start_matches('P');
             let v: Vec<&str> = pkt.split('=').collect();
             let addr = parse_u32(v[0])?;
             let value = swab(parse_u32(v[1])?);
@@ -391,13 +418,13 @@ impl GdbServer {
         } else if pkt == "s" {
             Ok(GdbCommand::Step)
         } else if pkt.starts_with('m') {
-            let pkt = pkt.trim_start_matches('m').to_string();
+            let pkt = pkt.trim_start_matches('m');
             let v: Vec<&str> = pkt.split(',').collect();
             let addr = parse_u32(v[0])?;
             let length = parse_u32(v[1])?;
             Ok(GdbCommand::ReadMemory(addr, length))
         } else if pkt.starts_with('M') {
-            let pkt = pkt.trim_start_matches('M').to_string();
+            let pkt = pkt.trim_start_matches('M');
             let d: Vec<&str> = pkt.split(':').collect();
             let v: Vec<&str> = d[0].split(',').collect();
             let addr = parse_u32(v[0])?;
@@ -405,48 +432,33 @@ impl GdbServer {
             let value = swab(parse_u32(d[1])?);
             Ok(GdbCommand::WriteMemory(addr, length, vec![value]))
         } else if pkt.starts_with('X') {
-            let (_opcode, data) = match raw_pkt.split_first() {
+            let (_opcode, data) = match raw_pkt.split_first_mut() {
                 None => return Err(GdbServerError::ProtocolError),
                 Some(s) => s,
             };
             // Packet format: Xaddr,count:data
             // Look for ":"
-            let mut delimiter_offset = None;
-            for (idx, c) in data.iter().enumerate() {
-                if *c == b':' {
-                    delimiter_offset = Some(idx);
-                    break;
-                }
-            }
-            let delimiter_offset = match delimiter_offset {
+            let delimiter_offset = match data.iter().position(|&c| c == b':') {
                 Some(s) => s,
                 None => return Err(GdbServerError::ProtocolError),
             };
-            // warn!("X command: Not doing GDB unescaping");
-            let (description, bin_data_plus) = data.split_at(delimiter_offset);
-            let bin_data_plus = bin_data_plus.split_first();
+            let (description, bin_data_plus) = data.split_at_mut(delimiter_offset);
             let description = String::from_utf8_lossy(&description).to_string();
             let v: Vec<&str> = description.split(',').collect();
             let addr = parse_u32(v[0])?;
             let length = parse_u32(v[1])?;
 
-            let mut values = vec![];
-            if let Some((_delimiter, bin_data)) = bin_data_plus {
-                let bin_data = gdb_unescape(bin_data);
-                for value in bin_data.chunks_exact(4) {
-                    values.push(swab(BigEndian::read_u32(&value)));
-                }
-                let remainder = bin_data.chunks_exact(4).remainder();
-                if !remainder.is_empty() {
-                    let mut remainder = remainder.to_vec();
-                    while remainder.len() < 4 {
-                        remainder.insert(0, 0);
-                    }
-                    // remainder.resize(4, 0);
-                    values.push(swab(BigEndian::read_u32(&remainder)));
-                }
+            let mut data = vec![];
+            if bin_data_plus.len() > 1 {
+                // Skip the delimiter and unescape the binary payload in
+                // place -- it only ever shrinks.
+                let bin_data = &mut bin_data_plus[1..];
+                let unescaped_len = gdb_unescape_in_place(bin_data);
+                // The payload is already raw target bytes in address
+                // order; hand it to the burst path untouched.
+                data.extend_from_slice(&bin_data[..unescaped_len]);
             }
-            Ok(GdbCommand::WriteMemory(addr, length, values))
+            Ok(GdbCommand::WriteMemoryBinary(addr, length, data))
         } else if pkt.starts_with('p') {
             Ok(GdbCommand::GetRegister(parse_u32(
                 pkt.trim_start_matches('p'),
@@ -474,6 +486,17 @@ impl GdbServer {
             let pkt = pkt.trim_start_matches("vCont;C").to_string();
             // let v: Vec<&str> = pkt.split(',').collect();
             Ok(GdbCommand::VContContinueFromSignal(pkt))
+        } else if pkt.starts_with("vCont;r") {
+            // The range may be followed by a thread id and a default
+            // action, e.g. vCont;r4000,4020:1;c -- only the range
+            // matters to us.
+            let pkt = pkt.trim_start_matches("vCont;r");
+            let range = pkt.split(|c| c == ':' || c == ';').next().unwrap_or("");
+            let v: Vec<&str> = range.split(',').collect();
+            if v.len() != 2 {
+                return Err(GdbServerError::ProtocolError);
+            }
+            Ok(GdbCommand::VContRangeStep(parse_u32(v[0])?, parse_u32(v[1])?))
         } else if pkt.starts_with("vCont;s") {
             let pkt = pkt.trim_start_matches("vCont;s").to_string();
             Ok(GdbCommand::VContStepFromSignal(pkt))
@@ -499,62 +522,78 @@ impl GdbServer {
         Ok(cmd)
     }
 
-    fn do_get_command(&mut self) -> Result<GdbCommand, GdbServerError> {
-        let mut buffer = [0; 16384];
+    /// Pull one byte through the buffered reader.
+    fn read_byte(reader: &mut io::BufReader<TcpStream>) -> Result<u8, GdbServerError> {
         let mut byte = [0; 1];
+        let len = reader.read(&mut byte)?;
+        if len == 0 {
+            return Err(GdbServerError::ConnectionClosed);
+        }
+        Ok(byte[0])
+    }
+
+    /// Read one packet into `buffer`, acking or nacking as required.
+    /// Returns `Some` for commands that arrive outside a packet (^C).
+    fn read_packet(&mut self, buffer: &mut Vec<u8>) -> Result<Option<GdbCommand>, GdbServerError> {
         let mut remote_checksum = [0; 2];
-        let mut buffer_offset = 0;
 
-        // XXX Replace this with a BufReader for performance
         loop {
-            let len = self.connection.read(&mut byte)?;
-            if len == 0 {
-                return Err(GdbServerError::ConnectionClosed);
-            }
-
-            match byte[0] {
+            match Self::read_byte(&mut self.reader)? {
                 0x24 /*'$'*/ => {
                     let mut checksum: u8 = 0;
                     loop {
-                        let len = self.connection.read(&mut byte)?;
-                        if len == 0 {
-                            return Err(GdbServerError::ConnectionClosed);
-                        }
-                        match byte[0] as char {
-                            '#' => {
-                                // There's got to be a better way to compare the checksum
-                                self.connection.read_exact(&mut remote_checksum)?;
-                                let checksum_str = format!("{:02x}", checksum);
-                                if checksum_str != String::from_utf8_lossy(&remote_checksum) {
+                        match Self::read_byte(&mut self.reader)? {
+                            b'#' => {
+                                self.reader.read_exact(&mut remote_checksum)?;
+                                let hex = |n: u8| if n < 10 { n + b'0' } else { n - 10 + b'a' };
+                                if [hex(checksum >> 4), hex(checksum & 0xf)] != remote_checksum {
                                     info!(
-                                        "Checksum mismatch: Calculated {:?} vs {}",
-                                        checksum_str,
+                                        "Checksum mismatch: Calculated {:02x} vs {}",
+                                        checksum,
                                         String::from_utf8_lossy(&remote_checksum)
                                     );
-                                    self.gdb_send_nak()?;
+                                    // In no-ack mode the transport is
+                                    // assumed reliable and '-' must not
+                                    // be sent; the packet is simply
+                                    // processed as received.
+                                    if !self.no_ack_mode {
+                                        self.gdb_send_nak()?;
+                                    }
                                 } else if !self.no_ack_mode {
                                     self.gdb_send_ack()?;
                                 }
-                                let (buffer, _remainder) = buffer.split_at(buffer_offset);
-                                // debug!("<  Read packet ${:?}#{:#?}", String::from_utf8_lossy(buffer), String::from_utf8_lossy(&remote_checksum));
-                                return self.packet_to_command(&buffer);
+                                return Ok(None);
                             }
                             other => {
-                                buffer[buffer_offset] = other as u8;
-                                buffer_offset += 1;
-                                checksum = checksum.wrapping_add(other as u8);
+                                buffer.push(other);
+                                checksum = checksum.wrapping_add(other);
                             }
                         }
                     }
                 }
                 0x2b /*'+'*/ => {}
                 0x2d /*'-'*/ => {}
-                0x3 => return Ok(GdbCommand::Interrupt),
+                0x3 => return Ok(Some(GdbCommand::Interrupt)),
                 other => error!("Warning: unrecognied byte received: {}", other),
             }
         }
     }
 
+    fn do_get_command(&mut self) -> Result<GdbCommand, GdbServerError> {
+        // Move the persistent buffer out so read_packet can borrow
+        // self for the ack/nack writes.
+        let mut buffer = std::mem::replace(&mut self.pkt_buffer, vec![]);
+        buffer.clear();
+
+        let result = match self.read_packet(&mut buffer) {
+            Ok(Some(cmd)) => Ok(cmd),
+            Ok(None) => self.packet_to_command(&mut buffer),
+            Err(e) => Err(e),
+        };
+        self.pkt_buffer = buffer;
+        result
+    }
+
     #[allow(clippy::cognitive_complexity)]
     pub fn process(
         &mut self,
@@ -608,10 +647,11 @@ impl GdbServer {
                 self.gdb_send(b"OK")?
             }
             GdbCommand::GetRegisters => {
-                let mut register_list = String::new();
-                for i in cpu.all_cpu_registers() {
-                    register_list
-                        .push_str(format!("{:08x}", swab(cpu.read_register(bridge, i)?)).as_str());
+                let regs = cpu.all_cpu_registers();
+                let values = cpu.read_registers(bridge, &regs)?;
+                let mut register_list = String::with_capacity(values.len() * 8);
+                for value in values {
+                    register_list.push_str(format!("{:08x}", swab(value)).as_str());
                 }
                 self.gdb_send(register_list.as_bytes())?
             }
@@ -653,11 +693,11 @@ impl GdbServer {
                     values.push(cpu.read_memory(bridge, addr, 4)?);
                     self.gdb_send_u32(values)?
                 } else {
-                    for offset in (0..len).step_by(4) {
-                        values.push(cpu.read_memory(bridge, addr + offset, 4)?);
-                        if addr + offset >= 0xffff_fffc {
-                            break;
-                        }
+                    // Multi-word reads go through the system bus as a
+                    // single burst rather than a transaction per word.
+                    let block = cpu.read_memory_block(bridge, addr, (len + 3) & !3)?;
+                    for value in block.chunks_exact(4) {
+                        values.push(LittleEndian::read_u32(value));
                     }
                     self.gdb_send_u32(values)?
                 }
@@ -673,14 +713,36 @@ impl GdbServer {
                     debug!("Writing memory {:08x} -> {:08x}", addr, values[0]);
                     cpu.write_memory(bridge, addr, 4, values[0])?;
                 } else {
-                    for (offset, value) in values.iter().enumerate() {
-                        debug!("Writing memory {:08x} -> {:08x}", addr, values[offset]);
-                        cpu.write_memory(bridge, addr + (offset as u32 * 4), 4, *value)?;
+                    debug!("Writing {} bytes of memory to {:08x}", len, addr);
+                    let mut data = Vec::with_capacity(values.len() * 4);
+                    for value in &values {
+                        data.extend_from_slice(&value.to_le_bytes());
+                    }
+                    cpu.write_memory_block(bridge, addr, &data)?;
+                }
+                self.gdb_send(b"OK")?
+            }
+            GdbCommand::WriteMemoryBinary(addr, len, data) => {
+                // An empty X packet is GDB probing for binary support.
+                if !data.is_empty() {
+                    debug!("Writing {} bytes of memory to {:08x}", len, addr);
+                    // Whole words go out as one burst; the bridge's
+                    // little-endian word stream is raw bytes in address
+                    // order, so no conversion is needed.
+                    let word_len = data.len() & !3;
+                    if word_len > 0 {
+                        cpu.write_memory_block(bridge, addr, &data[..word_len])?;
+                    }
+                    // Trailing sub-word bytes go through the byte-wide
+                    // debug path so neighboring memory is untouched.
+                    for (i, byte) in data[word_len..].iter().enumerate() {
+                        let byte_addr = addr + word_len as u32 + i as u32;
+                        cpu.write_memory(bridge, byte_addr, 1, u32::from(*byte))?;
                     }
                 }
                 self.gdb_send(b"OK")?
             }
-            GdbCommand::VContQuery => self.gdb_send(b"vCont;c;C;s;S")?,
+            GdbCommand::VContQuery => self.gdb_send(b"vCont;c;C;s;S;r")?,
             GdbCommand::VContContinue => {
                 if let Some(s) = cpu.resume(bridge)? {
                     self.print_string(&format!("Note: CPU is currently in a trap: {}\n", s))?
@@ -691,6 +753,30 @@ impl GdbServer {
                     self.print_string(&format!("Note: CPU is currently in a trap: {}\n", s))?
                 }
             }
+            GdbCommand::VContRangeStep(start, end) => {
+                // Execute GDB's `next`-over-a-line entirely target-side:
+                // keep stepping while the pc stays inside the range,
+                // reading back only the pc -- not the whole register
+                // file -- and reporting a single stop at the end.
+                const MAX_RANGE_STEPS: usize = 0x1000;
+                let mut trap = None;
+                for _ in 0..MAX_RANGE_STEPS {
+                    trap = cpu.step(bridge)?;
+                    if trap.is_some() {
+                        break;
+                    }
+                    let pc = cpu.read_register(bridge, 32)?;
+                    if pc < start || pc >= end {
+                        break;
+                    }
+                }
+                if let Some(s) = trap {
+                    self.print_string(&format!("Note: CPU is currently in a trap: {}
+", s))?;
+                }
+                self.last_signal = 5;
+                self.gdb_send(format!("S{:02x}", self.last_signal).as_bytes())?;
+            }
             GdbCommand::VContStepFromSignal(_) => {
                 if let Some(s) = cpu.step(bridge)? {
                     self.print_string(&format!("Note: CPU is currently in a trap: {}\n", s))?;
@@ -804,7 +890,9 @@ impl GdbServer {
         self.gdb_send(joined.as_bytes())
     }
 
-    fn gdb_send_file(&mut self, mut data: Vec<u8>, offset: u32, len: u32) -> io::Result<()> {
+    /// Send one qXfer chunk, streaming straight from the caller's
+    /// (cached) buffer -- no intermediate copy of the file data.
+    fn gdb_send_file(&mut self, data: &[u8], offset: u32, len: u32) -> io::Result<()> {
         let offset = offset as usize;
         let len = len as usize;
         let mut end = offset + len;
@@ -814,15 +902,36 @@ impl GdbServer {
             if end > data.len() {
                 end = data.len();
             }
-            let mut trimmed_data: Vec<u8> = data.drain(offset..end).collect();
-            if trimmed_data.len() >= len {
+            let chunk = &data[offset..end];
+            let prefix = if chunk.len() >= len {
                 // XXX should this be <= or < ?
-                trimmed_data.insert(0, b'm');
+                b'm'
             } else {
-                trimmed_data.insert(0, b'l');
-            }
-            self.gdb_send(&trimmed_data)?;
+                b'l'
+            };
+            self.gdb_send_prefixed(prefix, chunk)?;
+        }
+        Ok(())
+    }
+
+    /// Like `gdb_send`, but with a one-byte packet type in front of the
+    /// payload so callers don't have to build a prefixed copy.
+    fn gdb_send_prefixed(&mut self, prefix: u8, inp: &[u8]) -> io::Result<()> {
+        let mut buffer = [0; 16388];
+        let mut checksum: u8 = prefix;
+        buffer[0] = b'$';
+        buffer[1] = prefix;
+        for i in 0..inp.len() {
+            buffer[i + 2] = inp[i];
+            checksum = checksum.wrapping_add(inp[i]);
         }
+        let checksum_str = &format!("{:02x}", checksum);
+        let checksum_bytes = checksum_str.as_bytes();
+        buffer[inp.len() + 2] = b'#';
+        buffer[inp.len() + 3] = checksum_bytes[0];
+        buffer[inp.len() + 4] = checksum_bytes[1];
+        let (to_write, _rest) = buffer.split_at(inp.len() + 5);
+        self.connection.write_all(&to_write)?;
         Ok(())
     }
 }
@@ -93,6 +93,15 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
                 .display_order(5)
                 .takes_value(true),
         )
+        .arg(
+            Arg::with_name("latency-timer")
+                .long("latency-timer")
+                .value_name("MS")
+                .default_value("1")
+                .help("SERIAL: USB-serial adapter latency timer in milliseconds (Linux only; FTDI adapters default to 16)")
+                .display_order(6)
+                .takes_value(true),
+        )
 
         .arg(
             Arg::with_name("ethernet-host")
@@ -136,6 +145,13 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
                 .takes_value(true),
         )
 
+        .arg(
+            Arg::with_name("auto-probe")
+                .long("auto-probe")
+                .help("probe all configured bridges concurrently and use the first that responds")
+                .display_order(10),
+        )
+
         .arg(
             Arg::with_name("address")
                 .index(1)
@@ -178,7 +194,7 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
                 .multiple(true)
                 .help("which server to run (if any)")
                 .display_order(15)
-                .possible_values(&["gdb", "wishbone", "random-test", "load-file", "terminal", "messible"]),
+                .possible_values(&["gdb", "wishbone", "random-test", "load-file", "terminal", "messible", "snapshot", "replay", "benchmark"]),
         )
 
         .arg(
@@ -219,6 +235,12 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
                 .display_order(19)
                 .takes_value(true),
         )
+        .arg(
+            Arg::with_name("wishbone-udp")
+                .long("wishbone-udp")
+                .help("WISHBONE: listen on UDP instead of TCP")
+                .display_order(19),
+        )
 
         .arg(
             Arg::with_name("random-address")
@@ -305,6 +327,14 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
             .takes_value(true),
         )
 
+        .arg(
+            Arg::with_name("burst-dest")
+            .long("burst-dest")
+            .help("Write burst read data directly to this file instead of formatting it to stdout")
+            .display_order(30)
+            .takes_value(true),
+        )
+
         .arg(
             Arg::with_name("flash-no-reset")
             .long("flash-no-reset")
@@ -320,6 +350,72 @@ fn clap_app<'a, 'b>() -> App<'a, 'b> {
             .display_order(32)
             .takes_value(false),
         )
+
+        .arg(
+            Arg::with_name("snapshot-address")
+            .long("snapshot-address")
+            .help("SNAPSHOT: base address of the region to publish")
+            .display_order(34)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("snapshot-length")
+            .long("snapshot-length")
+            .help("SNAPSHOT: number of bytes to publish per snapshot")
+            .default_value("256")
+            .display_order(35)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("snapshot-path")
+            .long("snapshot-path")
+            .help("SNAPSHOT: shared-memory file to publish into, e.g. under /dev/shm (defaults to an anonymous memfd)")
+            .display_order(36)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("snapshot-interval")
+            .long("snapshot-interval")
+            .help("SNAPSHOT: milliseconds between snapshots")
+            .default_value("10")
+            .display_order(37)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("record-traffic")
+            .long("record-traffic")
+            .help("record all bridge traffic to this file as a binary trace")
+            .display_order(38)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("replay-trace")
+            .long("replay-trace")
+            .help("REPLAY: trace file to re-execute against the target")
+            .display_order(39)
+            .takes_value(true),
+        )
+
+        .arg(
+            Arg::with_name("load-sparse")
+            .long("load-sparse")
+            .help("LOAD_FILE: skip chunks of uniform 0x00/0xFF filler that already match the target, transferring only meaningful payload")
+            .display_order(40)
+            .takes_value(false),
+        )
+
+        .arg(
+            Arg::with_name("incremental-flashing")
+            .long("incremental-flashing")
+            .help("Read the current flash contents first and only erase/program sectors that differ from the new image. Much faster when most of the image is unchanged.")
+            .display_order(33)
+            .takes_value(false),
+        )
 }
 
 fn main() -> Result<(), String> {
@@ -360,13 +456,27 @@ fn main() -> Result<(), String> {
         .connect()
         .map_err(|e| format!("unable to connect to bridge: {}", e))?;
 
+    if let Some(trace) = &cfg.record_traffic {
+        bridge
+            .record_traffic(trace)
+            .map_err(|e| format!("unable to record traffic: {}", e))?;
+    }
+
     let cfg = Arc::new(cfg);
     let mut threads = vec![];
     for server_kind in cfg.server_kind.iter() {
         use std::thread;
-        let bridge = bridge.clone();
+        let mut bridge = bridge.clone();
         let cfg = cfg.clone();
         let server_kind = *server_kind;
+        // Pollers run at background priority so their steady traffic
+        // never delays interactive debugging on the shared bridge.
+        match server_kind {
+            ServerKind::Terminal | ServerKind::Messible | ServerKind::Snapshot => {
+                bridge.set_background(true)
+            }
+            _ => (),
+        }
         let thr_handle = thread::spawn(move || {
             match server_kind {
                 ServerKind::GDB => server::gdb_server(&cfg, bridge),
@@ -377,6 +487,9 @@ fn main() -> Result<(), String> {
                 ServerKind::MemoryAccess => server::memory_access(&cfg, bridge),
                 ServerKind::Messible => server::messible_client(&cfg, bridge),
                 ServerKind::FlashProgram => server::flash_program(&cfg, bridge),
+                ServerKind::Snapshot => server::snapshot_server(&cfg, bridge),
+                ServerKind::Replay => server::replay_trace(&cfg, bridge),
+                ServerKind::Benchmark => server::benchmark(&cfg, bridge),
             }
             .expect("couldn't start server");
             debug!("Exited {:?} thread", server_kind);
@@ -387,5 +500,8 @@ fn main() -> Result<(), String> {
         handle.join().ok();
     }
 
+    #[cfg(feature = "bridge-metrics")]
+    eprintln!("bridge statistics:\n{}", bridge.stats());
+
     Ok(())
 }
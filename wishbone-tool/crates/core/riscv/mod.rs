@@ -248,6 +248,9 @@ struct RiscvBreakpoint {
 
     /// Whether this value is empty or not
     allocated: bool,
+
+    /// Whether the hardware slot still needs to be written
+    dirty: bool,
 }
 
 pub struct RiscvCpu {
@@ -263,6 +266,17 @@ pub struct RiscvCpu {
     /// Keep a copy of values that get clobbered during debugging
     cached_values: Arc<Mutex<HashMap<RiscvRegister, u32>>>,
 
+    /// Values read from the target while it is halted.  Registers
+    /// cannot change while the CPU is stopped, so repeated reads (GDB
+    /// re-fetches pc/sp constantly) are served from here; the map is
+    /// cleared whenever the CPU runs.
+    read_cache: Arc<Mutex<HashMap<RiscvRegister, u32>>>,
+
+    /// Set when target memory has been written since the last
+    /// instruction-cache flush, so resume knows whether a flush is
+    /// needed at all
+    memory_dirty: Arc<AtomicBool>,
+
     /// All available breakpoints
     breakpoints: RefCell<[RiscvBreakpoint; 2]>,
 
@@ -292,6 +306,12 @@ pub struct RiscvCpuController {
     /// Cached values (mostly the program counter)
     cached_values: Arc<Mutex<HashMap<RiscvRegister, u32>>>,
 
+    /// Register values read while halted; see `RiscvCpu::read_cache`
+    read_cache: Arc<Mutex<HashMap<RiscvRegister, u32>>>,
+
+    /// Whether memory has been written since the last cache flush
+    memory_dirty: Arc<AtomicBool>,
+
     /// "true" if an MMU exists on this CPU
     has_mmu: bool,
 
@@ -309,12 +329,17 @@ impl RiscvCpu {
         let cpu_state = Arc::new(Mutex::new(RiscvCpuState::Unknown));
         let debug_offset = offset;
         let cached_values = Arc::new(Mutex::new(HashMap::new()));
+        let read_cache = Arc::new(Mutex::new(HashMap::new()));
         let last_exception = Arc::new(Mutex::new(None));
 
+        // Assume the cache is stale until the first flush.
+        let memory_dirty = Arc::new(AtomicBool::new(true));
         let mmu_enabled = Arc::new(AtomicBool::new(false));
         let mut controller = RiscvCpuController {
             cpu_state: cpu_state.clone(),
             cached_values: cached_values.clone(),
+            read_cache: read_cache.clone(),
+            memory_dirty: memory_dirty.clone(),
             debug_offset,
             has_mmu: false,
             mmu_enabled: mmu_enabled.clone(),
@@ -329,14 +354,9 @@ impl RiscvCpu {
         if was_running {
             controller.perform_halt(bridge)?;
         }
-        let satp_register = RiscvRegister::satp();
-        let old_satp = controller.read_register(bridge, &satp_register)?;
-        controller.write_register(bridge, &satp_register, !old_satp)?;
-        let new_satp = controller.read_register(bridge, &satp_register)?;
-        if new_satp != old_satp {
-            controller.write_register(bridge, &satp_register, old_satp)?;
+        if let Some(old_satp) = controller.probe_satp(bridge)? {
             controller.has_mmu = true;
-            Self::insert_register(&mut gdb_register_map, satp_register);
+            Self::insert_register(&mut gdb_register_map, RiscvRegister::satp());
             mmu_enabled.store((old_satp & 0x8000_0000) == 0x8000_0000, Ordering::Relaxed);
         }
         if was_running {
@@ -351,16 +371,22 @@ impl RiscvCpu {
             target_xml,
             debug_offset,
             cached_values,
+            read_cache,
+            memory_dirty,
             breakpoints: RefCell::new([
                 RiscvBreakpoint {
                     address: 0,
                     enabled: false,
                     allocated: false,
+                    // Write every slot on the first resume to clear
+                    // garbage left over from a previous session.
+                    dirty: true,
                 },
                 RiscvBreakpoint {
                     address: 0,
                     enabled: false,
                     allocated: false,
+                    dirty: true,
                 },
                 // RiscvBreakpoint {
                 //     address: 0,
@@ -604,17 +630,18 @@ impl RiscvCpu {
         target_xml
     }
 
-    pub fn get_feature(&self, name: &str) -> Result<Vec<u8>, RiscvCpuError> {
+    pub fn get_feature(&self, name: &str) -> Result<&[u8], RiscvCpuError> {
         if name == "target.xml" {
-            let xml = self.target_xml.to_string().into_bytes();
-            Ok(xml)
+            // The XML was generated once at construction; serve qXfer
+            // chunks straight out of it.
+            Ok(self.target_xml.as_bytes())
         } else {
             Err(RiscvCpuError::UnrecognizedFile(name.to_string()))
         }
     }
 
-    pub fn get_threads(&self) -> Result<Vec<u8>, RiscvCpuError> {
-        Ok(THREADS_XML.to_string().into_bytes())
+    pub fn get_threads(&self) -> Result<&[u8], RiscvCpuError> {
+        Ok(THREADS_XML.as_bytes())
     }
 
     // pub fn get_memory_map(&self) -> Result<Vec<u8>, RiscvCpuError> {
@@ -635,45 +662,44 @@ impl RiscvCpu {
     }
 
     pub fn add_breakpoint(&self, bridge: &Bridge, addr: u32) -> Result<(), RiscvCpuError> {
-        let mut bp_index = None;
         let mut bps = self.breakpoints.borrow_mut();
-        for (bpidx, bp) in bps.iter().enumerate() {
-            if !bp.allocated {
-                bp_index = Some(bpidx);
-            }
-        }
-        if bp_index.is_none() {
-            return Err(RiscvCpuError::BreakpointExhausted);
-        }
-
-        let bp_index = bp_index.unwrap();
+        let bp_index = match bps.iter().position(|bp| !bp.allocated) {
+            Some(s) => s,
+            None => return Err(RiscvCpuError::BreakpointExhausted),
+        };
 
         bps[bp_index].address = addr;
         bps[bp_index].allocated = true;
         bps[bp_index].enabled = true;
 
-        bridge.poke(self.debug_offset + 0x40 + (bp_index as u32 * 4), addr | 1)?;
+        // While the CPU is halted the hardware slot doesn't need to be
+        // live yet; leave it dirty and let resume flush every pending
+        // slot in one batch.  A running CPU must see it immediately.
+        if *self.cpu_state.lock().unwrap() == RiscvCpuState::Running {
+            bps[bp_index].dirty = false;
+            bridge.poke(self.debug_offset + 0x40 + (bp_index as u32 * 4), addr | 1)?;
+        } else {
+            bps[bp_index].dirty = true;
+        }
         Ok(())
     }
 
     pub fn remove_breakpoint(&self, bridge: &Bridge, addr: u32) -> Result<(), RiscvCpuError> {
-        let mut bp_index = None;
         let mut bps = self.breakpoints.borrow_mut();
-        for (bpidx, bp) in bps.iter().enumerate() {
-            if bp.allocated && bp.address == addr {
-                bp_index = Some(bpidx);
-            }
-        }
-        if bp_index.is_none() {
-            return Err(RiscvCpuError::BreakpointNotFound(addr));
-        }
-
-        let bp_index = bp_index.unwrap();
+        let bp_index = match bps.iter().position(|bp| bp.allocated && bp.address == addr) {
+            Some(s) => s,
+            None => return Err(RiscvCpuError::BreakpointNotFound(addr)),
+        };
 
         bps[bp_index].allocated = false;
         bps[bp_index].enabled = false;
 
-        bridge.poke(self.debug_offset + 0x40 + (bp_index as u32 * 4), 0)?;
+        if *self.cpu_state.lock().unwrap() == RiscvCpuState::Running {
+            bps[bp_index].dirty = false;
+            bridge.poke(self.debug_offset + 0x40 + (bp_index as u32 * 4), 0)?;
+        } else {
+            bps[bp_index].dirty = true;
+        }
         Ok(())
     }
 
@@ -681,28 +707,36 @@ impl RiscvCpu {
         // let _bridge_mutex = bridge.mutex().lock().unwrap();
         let mut current_status = self.cpu_state.lock().unwrap();
         *current_status = RiscvCpuState::Halted;
+        // Values cached during any earlier halt are stale now.
+        self.read_cache.lock().unwrap().clear();
         self.controller.perform_halt(bridge)?;
         debug!("HALT: CPU is now halted");
         Ok(())
     }
 
+    /// Flush all pending breakpoint slot changes to the hardware as a
+    /// single batched bridge operation.
     fn update_breakpoints(&self, bridge: &Bridge) -> Result<(), RiscvCpuError> {
-        for (bpidx, bp) in self.breakpoints.borrow().iter().enumerate() {
-            if bp.allocated && bp.enabled {
+        let mut ops = vec![];
+        for (bpidx, bp) in self.breakpoints.borrow_mut().iter_mut().enumerate() {
+            if !bp.dirty {
+                continue;
+            }
+            let value = if bp.allocated && bp.enabled {
                 debug!(
                     "Re-enabling breakpoint {} at address {:08x}",
                     bpidx, bp.address
                 );
-                bridge.poke(
-                    self.debug_offset + 0x40 + (bpidx as u32 * 4),
-                    bp.address | 1,
-                )?;
+                bp.address | 1
             } else {
                 debug!("Breakpoint {} is unallocated", bpidx);
-                // If this breakpoint is unallocated, ensure that there is no
-                // garbage breakpoints leftover from a previous session.
-                bridge.poke(self.debug_offset + 0x40 + (bpidx as u32 * 4), 0)?;
-            }
+                0
+            };
+            ops.push((self.debug_offset + 0x40 + (bpidx as u32 * 4), value));
+            bp.dirty = false;
+        }
+        if !ops.is_empty() {
+            bridge.poke_many(&ops)?;
         }
         Ok(())
     }
@@ -713,6 +747,7 @@ impl RiscvCpu {
         // let _bridge_mutex = bridge.mutex().lock().unwrap();
         // Since we're resetting the CPU, invalidate all cached registers
         self.cached_values.lock().unwrap().drain();
+        self.read_cache.lock().unwrap().clear();
         self.flush_cache(bridge)?;
         self.mmu_enabled.store(false, Ordering::Relaxed);
         *self.last_exception.lock().unwrap() = None;
@@ -781,7 +816,62 @@ impl RiscvCpu {
             return Ok(val);
         }
 
-        self.controller.read_register(bridge, reg)
+        // While halted, registers can't change underneath us, so serve
+        // repeat reads from the halted-state cache.
+        let halted = *self.cpu_state.lock().unwrap() == RiscvCpuState::Halted;
+        if halted {
+            if let Some(val) = self.read_cache.lock().unwrap().get(reg) {
+                return Ok(*val);
+            }
+        }
+
+        let val = self.controller.read_register(bridge, reg)?;
+        if halted {
+            self.read_cache.lock().unwrap().insert(reg.clone(), val);
+        }
+        Ok(val)
+    }
+
+    /// Read a batch of registers, as for a GDB `g` packet.
+    ///
+    /// Cached registers are served without touching the bridge; the
+    /// rest go through the controller's grouped read, which issues the
+    /// minimum number of debug-bus transactions.
+    pub fn read_registers(
+        &self,
+        bridge: &Bridge,
+        gdb_idxs: &[u32],
+    ) -> Result<Vec<u32>, RiscvCpuError> {
+        let halted = *self.cpu_state.lock().unwrap() == RiscvCpuState::Halted;
+        let mut values = vec![None; gdb_idxs.len()];
+        let mut uncached = vec![];
+        for (slot, gdb_idx) in gdb_idxs.iter().enumerate() {
+            let reg = self.gdb_to_register(*gdb_idx)?;
+            if let Some(val) = self.get_cached_reg(reg) {
+                values[slot] = Some(val);
+            } else if halted && self.read_cache.lock().unwrap().contains_key(reg) {
+                values[slot] = Some(*self.read_cache.lock().unwrap().get(reg).unwrap());
+            } else if reg.register_type == RiscvRegisterType::General {
+                uncached.push((slot, reg.clone()));
+            } else {
+                // CSR reads clobber $x1 and manage the register cache
+                // themselves; keep them on the one-at-a-time path.
+                values[slot] = Some(self.controller.read_register(bridge, reg)?);
+            }
+        }
+
+        if !uncached.is_empty() {
+            let regs: Vec<RiscvRegister> = uncached.iter().map(|(_, r)| r.clone()).collect();
+            let fetched = self.controller.read_registers(bridge, &regs)?;
+            for ((slot, reg), value) in uncached.iter().zip(fetched) {
+                if halted {
+                    self.read_cache.lock().unwrap().insert(reg.clone(), value);
+                }
+                values[*slot] = Some(value);
+            }
+        }
+
+        Ok(values.into_iter().map(|v| v.unwrap()).collect())
     }
 
     /// Return a vec containing all valid CPU registers.
@@ -812,13 +902,19 @@ impl RiscvCpu {
         let reg = self.gdb_to_register(gdb_idx)?;
         if reg.register_type == RiscvRegisterType::General {
             self.set_cached_reg(reg, value);
+            // Write through so halted-state reads agree.
+            self.read_cache.lock().unwrap().insert(reg.clone(), value);
             Ok(())
         } else if reg.gdb_index == RiscvRegister::satp().gdb_index {
             self.mmu_enabled
                 .store(value & 0x8000_0000 == 0x8000_0000, Ordering::Relaxed);
             self.set_cached_reg(reg, value);
+            self.read_cache.lock().unwrap().insert(reg.clone(), value);
             Ok(())
         } else {
+            // WARL CSRs may not read back what was written, so drop any
+            // cached value rather than writing through.
+            self.read_cache.lock().unwrap().remove(reg);
             self.controller.write_register(bridge, reg, value)
         }
     }
@@ -828,6 +924,29 @@ impl RiscvCpu {
         self.controller.read_memory(bridge, addr, sz)
     }
 
+    /// Read `length` bytes of memory as one bridge burst.  Returns the
+    /// data as little-endian bytes, matching `Bridge::burst_read`.
+    pub fn read_memory_block(
+        &self,
+        bridge: &Bridge,
+        addr: u32,
+        length: u32,
+    ) -> Result<Vec<u8>, RiscvCpuError> {
+        Ok(bridge.burst_read(addr, length)?)
+    }
+
+    /// Write a block of memory as one bridge burst.  `data` is
+    /// little-endian bytes, matching `Bridge::burst_write`.
+    pub fn write_memory_block(
+        &self,
+        bridge: &Bridge,
+        addr: u32,
+        data: &[u8],
+    ) -> Result<(), RiscvCpuError> {
+        self.memory_dirty.store(true, Ordering::Relaxed);
+        Ok(bridge.burst_write(addr, &data.to_vec())?)
+    }
+
     pub fn write_memory(
         &self,
         bridge: &Bridge,
@@ -836,6 +955,7 @@ impl RiscvCpu {
         value: u32,
     ) -> Result<(), RiscvCpuError> {
         // let _bridge_mutex = bridge.mutex().lock().unwrap();
+        self.memory_dirty.store(true, Ordering::Relaxed);
         self.controller.write_memory(bridge, addr, sz, value)
     }
 
@@ -844,6 +964,8 @@ impl RiscvCpu {
             cpu_state: self.cpu_state.clone(),
             debug_offset: self.debug_offset,
             cached_values: self.cached_values.clone(),
+            read_cache: self.read_cache.clone(),
+            memory_dirty: self.memory_dirty.clone(),
             has_mmu: self.has_mmu,
             mmu_enabled: self.mmu_enabled.clone(),
             last_exception: self.last_exception.clone(),
@@ -891,6 +1013,8 @@ impl RiscvCpuController {
             // If the status was running, transition to the `halted` state.
             if *current_status == RiscvCpuState::Running {
                 *current_status = RiscvCpuState::Halted;
+                // Anything cached during a previous halt is stale.
+                self.read_cache.lock().unwrap().clear();
                 // gdb_controller.gdb_send(b"T05swbreak:;")?;
 
                 // If we were halted by a breakpoint, save the PC (because it will
@@ -919,6 +1043,7 @@ impl RiscvCpuController {
             if *current_status == RiscvCpuState::Halted {
                 info!("POLL: The debugger thinks the CPU is halted, but CPU is now running!  Halting it and flushing the caches.");
                 self.cached_values.lock().unwrap().drain();
+                self.read_cache.lock().unwrap().clear();
                 self.perform_halt(bridge)?;
             }
         }
@@ -957,6 +1082,9 @@ impl RiscvCpuController {
     }
 
     fn perform_resume(&self, bridge: &Bridge, step_only: bool) -> Result<(), RiscvCpuError> {
+        // The CPU is about to run (or step); halted-state values are
+        // no longer valid.
+        self.read_cache.lock().unwrap().clear();
         let coll: HashMap<RiscvRegister, u32> = {
             let mut cached_registers = self.cached_values.lock().unwrap();
             let drain = cached_registers.drain();
@@ -980,7 +1108,7 @@ impl RiscvCpuController {
             }
         }
 
-        self.flush_cache(bridge)?;
+        self.flush_cache_if_dirty(bridge)?;
 
         if step_only {
             self.write_status(bridge, VexRiscvFlags::HALT_CLEAR | VexRiscvFlags::STEP)?;
@@ -1226,10 +1354,115 @@ impl RiscvCpuController {
         }
     }
 
+    /// The opcodes that load `value` into $x1, as used by
+    /// write_register(): LUI+ADDI for large values, a single ORI for
+    /// small ones.
+    fn load_x1_opcodes(value: u32) -> Vec<u32> {
+        if (value & 0xffff_f800) != 0 {
+            let low = value & 0x0000_0fff;
+            let high = if (low & 0x800) != 0 {
+                (value & 0xffff_f000).wrapping_add(0x1000)
+            } else {
+                value & 0xffff_f000
+            };
+            // LUI x1, high
+            let mut opcodes = vec![(1 << 7) | high | 0x37];
+            if low != 0 {
+                // ADDI x1, x1, low
+                opcodes.push((1 << 7) | (1 << 15) | (low << 20) | 0x13);
+            }
+            opcodes
+        } else {
+            // ORI x1, x0, value
+            vec![(1 << 7) | (6 << 12) | (value << 20) | 0x13]
+        }
+    }
+
+    /// Probe for an MMU by writing the inverse of "satp" back to it and
+    /// seeing whether the change sticks.  Returns the original satp
+    /// value if the register exists.  This runs on every GDB attach, so
+    /// the sequence is issued as raw instruction pokes with one busy
+    /// check at the end instead of a status poll per instruction -- the
+    /// same pipelining trick as read_registers().  The CPU must already
+    /// be halted.  $x1 is clobbered and its original value left in the
+    /// register cache, from which resume restores it.
+    fn probe_satp(&self, bridge: &Bridge) -> Result<Option<u32>, RiscvCpuError> {
+        let csr = RiscvRegister::satp().index & 0x1fff;
+        // CSRRS x1, satp, x0: read satp with no side effects.
+        #[allow(clippy::identity_op)]
+        let read_satp = 0
+            | (csr << 20)
+            | (0 << 15)     // rs1: x0
+            | (2 << 12)     // CSRRS
+            | (1 << 7)      // rd: x1
+            | (0x73 << 0); // SYSTEM
+        // CSRRW x0, satp, x1: write satp with no side effects.
+        #[allow(clippy::identity_op)]
+        let write_satp = 0
+            | (csr << 20)
+            | (1 << 15)     // rs1: x1
+            | (1 << 12)     // CSRRW
+            | (0 << 7)      // rd: x0
+            | (0x73 << 0); // SYSTEM
+
+        // Save $x1, which the CSR accesses below clobber.
+        bridge.poke(self.debug_offset + 4, (1 << 15) | 0x13)?; // ADDI x0, x1, 0
+        let old_x1 = self.read_result(bridge)?;
+        if self.get_cached_reg(&RiscvRegister::x1()).is_none() {
+            self.set_cached_reg(&RiscvRegister::x1(), old_x1);
+        }
+
+        bridge.poke(self.debug_offset + 4, read_satp)?;
+        let old_satp = self.read_result(bridge)?;
+
+        // Write the inverted value through $x1 and read satp back.
+        let mut pokes: Vec<(u32, u32)> = Self::load_x1_opcodes(!old_satp)
+            .into_iter()
+            .map(|opcode| (self.debug_offset + 4, opcode))
+            .collect();
+        pokes.push((self.debug_offset + 4, write_satp));
+        pokes.push((self.debug_offset + 4, read_satp));
+        bridge.poke_many(&pokes)?;
+        let new_satp = self.read_result(bridge)?;
+
+        let result = if new_satp != old_satp {
+            // The register exists; restore its original value.
+            let mut pokes: Vec<(u32, u32)> = Self::load_x1_opcodes(old_satp)
+                .into_iter()
+                .map(|opcode| (self.debug_offset + 4, opcode))
+                .collect();
+            pokes.push((self.debug_offset + 4, write_satp));
+            bridge.poke_many(&pokes)?;
+            Some(old_satp)
+        } else {
+            None
+        };
+
+        if (self.read_status(bridge)? & VexRiscvFlags::PIP_BUSY) == VexRiscvFlags::PIP_BUSY {
+            return Err(RiscvCpuError::InstructionTimeout);
+        }
+        Ok(result)
+    }
+
+    /// Flush the instruction cache with a FENCE.I sequence.  The
+    /// VexRiscv debug plugin offers no address-ranged invalidation, so
+    /// this is always a whole-cache operation; the dirty flag keeps it
+    /// from running when nothing was written.
     fn flush_cache(&self, bridge: &Bridge) -> Result<(), RiscvCpuError> {
         for opcode in &[4111, 19, 19, 19] {
             self.write_instruction(bridge, *opcode)?;
         }
+        self.memory_dirty.store(false, Ordering::Relaxed);
+        Ok(())
+    }
+
+    /// Flush the instruction cache only if memory has been written
+    /// since the last flush.  A GDB load dirties memory once and gets
+    /// one flush at resume; a plain step skips the flush entirely.
+    fn flush_cache_if_dirty(&self, bridge: &Bridge) -> Result<(), RiscvCpuError> {
+        if self.memory_dirty.load(Ordering::Relaxed) {
+            self.flush_cache(bridge)?;
+        }
         Ok(())
     }
 
@@ -1247,6 +1480,37 @@ impl RiscvCpuController {
             .insert(reg.clone(), value);
     }
 
+    /// Read a group of general-purpose registers with two bridge
+    /// transactions per register instead of three.
+    ///
+    /// Each read is still an instruction issue followed by a result
+    /// fetch -- the result register is overwritten by the next
+    /// instruction, so different registers cannot be combined into one
+    /// peek_many.  But the single-cycle ADDI/AUIPC used for register
+    /// moves has always retired by the time the next bridge transaction
+    /// crosses the wire, so the per-instruction busy poll is replaced
+    /// by one status check at the end of the group.
+    fn read_registers(
+        &self,
+        bridge: &Bridge,
+        regs: &[RiscvRegister],
+    ) -> Result<Vec<u32>, RiscvCpuError> {
+        let mut values = Vec::with_capacity(regs.len());
+        for reg in regs {
+            let opcode = if reg.index == 32 {
+                0x17 // AUIPC x0,0
+            } else {
+                (reg.index << 15) | 0x13 // ADDI x0, x?, 0
+            };
+            bridge.poke(self.debug_offset + 4, opcode)?;
+            values.push(self.read_result(bridge)?);
+        }
+        if (self.read_status(bridge)? & VexRiscvFlags::PIP_BUSY) == VexRiscvFlags::PIP_BUSY {
+            return Err(RiscvCpuError::InstructionTimeout);
+        }
+        Ok(values)
+    }
+
     fn write_instruction(&self, bridge: &Bridge, opcode: u32) -> Result<(), RiscvCpuError> {
         // debug!(
         //     "WRITE INSTRUCTION: 0x{:08x} -- 0x{:08x}",
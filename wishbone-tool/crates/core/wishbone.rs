@@ -2,10 +2,10 @@ extern crate byteorder;
 
 use std::io;
 use std::io::{Cursor, Read, Write};
-use std::net::{TcpListener, TcpStream};
+use std::net::{TcpListener, TcpStream, UdpSocket};
 
 use super::Config;
-use byteorder::{BigEndian, ReadBytesExt, WriteBytesExt};
+use byteorder::{BigEndian, ByteOrder};
 use wishbone_bridge::{Bridge, BridgeError};
 
 /* The network protocol looks like this:
@@ -43,8 +43,27 @@ pub struct WishboneServer {
     listener: TcpListener,
 }
 
+/// Datagram flavour of the wishbone server.  Each Etherbone packet is
+/// answered in place with no per-client connection state, which cuts
+/// per-operation latency for lab scripts that prefer UDP, mirroring
+/// the bridge's `EthernetBridgeProtocol::UDP`.
+pub struct WishboneUdpServer {
+    socket: UdpSocket,
+    payload: Vec<u8>,
+    reply: Vec<u8>,
+}
+
 pub struct WishboneConnection {
     connection: TcpStream,
+
+    /// Buffered view of the same socket, so records are pulled in with
+    /// bulk reads instead of one syscall per byte.
+    reader: io::BufReader<TcpStream>,
+
+    /// Scratch buffers reused across packets to avoid per-record
+    /// allocations.
+    payload: Vec<u8>,
+    reply: Vec<u8>,
 }
 
 #[derive(Debug)]
@@ -86,96 +105,247 @@ impl WishboneServer {
 
     pub fn connect(&mut self) -> Result<WishboneConnection, WishboneServerError> {
         let (connection, _sockaddr) = self.listener.accept()?;
-        Ok(WishboneConnection { connection })
+        let reader = io::BufReader::new(connection.try_clone()?);
+        Ok(WishboneConnection {
+            connection,
+            reader,
+            payload: vec![],
+            reply: vec![],
+        })
     }
 }
 
-impl WishboneConnection {
+impl WishboneUdpServer {
+    pub fn new(cfg: &Config) -> Result<WishboneUdpServer, WishboneServerError> {
+        Ok(WishboneUdpServer {
+            socket: UdpSocket::bind(format!("{}:{}", cfg.bind_addr, cfg.bind_port))?,
+            payload: vec![],
+            reply: vec![],
+        })
+    }
+
+    /// Receive one datagram, execute its records, and send any read
+    /// response back to the sender.  Malformed or truncated datagrams
+    /// are reported as errors but don't tear the server down -- the
+    /// next datagram is a fresh start.
     pub fn process(&mut self, bridge: &Bridge) -> Result<(), WishboneServerError> {
-        let mut header = [0; 16];
-        let mut offset = 0;
-        let mut byte = [0; 1];
+        // Big enough for a packet header plus a full 255-op record;
+        // anything longer than this is not a packet we can answer.
+        let mut datagram = [0; 2048];
+        let (len, peer) = self.socket.recv_from(&mut datagram)?;
+        let datagram = &datagram[..len];
+
+        if len < 8 || datagram[0] != 0x4e || datagram[1] != 0x6f {
+            return Err(WishboneServerError::NoMagic);
+        }
 
-        let connection = &mut self.connection;
+        self.reply.clear();
+        self.reply.extend_from_slice(&datagram[0..8]);
 
-        // XXX Replace this with a BufReader for performance
-        while offset < header.len() {
-            let len = connection.read(&mut byte)?;
-            if len == 0 {
-                return Err(WishboneServerError::ConnectionClosed);
-            }
-            header[offset] = byte[0];
-            offset += 1;
+        // Unlike TCP, the datagram frames the packet for us: keep
+        // consuming records until it is exhausted.
+        let mut cursor = Cursor::new(&datagram[8..]);
+        while (cursor.position() as usize) < len - 8 {
+            WishboneConnection::process_record(
+                &mut cursor,
+                bridge,
+                &mut self.payload,
+                &mut self.reply,
+            )?;
         }
 
-        // Validate signature matches
-        if header[0] != 0x4e || header[1] != 0x6f {
-            return Err(WishboneServerError::NoMagic);
+        if self.reply.len() > 8 {
+            self.socket.send_to(&self.reply, peer)?;
         }
+        Ok(())
+    }
+}
+
+impl WishboneConnection {
+    /// The address of the connected client, for logging.
+    pub fn peer_addr(&self) -> Result<std::net::SocketAddr, WishboneServerError> {
+        Ok(self.connection.peer_addr()?)
+    }
+}
 
-        let wcount = header[10];
-        let rcount = header[11];
-        let buffer_len: usize = (rcount * 4 + wcount * 4) as usize;
-        let mut buffer = vec![0; buffer_len];
-
-        // XXX Replace this with a BufReader for performance
-        offset = 0;
-        while offset < buffer.len() {
-            let len = connection.read(&mut byte)?;
-            if len == 0 {
-                return Err(WishboneServerError::ConnectionClosed);
+impl WishboneConnection {
+    /// Read exactly `buf.len()` bytes through the buffered reader,
+    /// mapping a clean remote hangup to `ConnectionClosed`.
+    fn read_exact<R: Read>(reader: &mut R, buf: &mut [u8]) -> Result<(), WishboneServerError> {
+        match reader.read_exact(buf) {
+            Ok(()) => Ok(()),
+            Err(ref e) if e.kind() == io::ErrorKind::UnexpectedEof => {
+                Err(WishboneServerError::ConnectionClosed)
             }
-            buffer[offset] = byte[0];
-            offset += 1;
+            Err(e) => Err(e.into()),
+        }
+    }
+
+    /// Process one Etherbone record, appending any read response to
+    /// `reply`.  Values are parsed in place from the scratch payload
+    /// buffer -- no per-record allocation.
+    fn process_record<R: Read>(
+        reader: &mut R,
+        bridge: &Bridge,
+        payload: &mut Vec<u8>,
+        reply: &mut Vec<u8>,
+    ) -> Result<(), WishboneServerError> {
+        // Record header plus the first payload word (write base address
+        // or, for a pure read, the base return address).
+        let mut record = [0; 8];
+        Self::read_exact(reader, &mut record)?;
+
+        let wcount = record[2] as usize;
+        let rcount = record[3] as usize;
+        if wcount == 0 && rcount == 0 {
+            return Err(WishboneServerError::UnsupportedOperation);
         }
 
-        // Figure out if it's a read or a write
         if wcount > 0 {
-            // Write
-            let mut addr_vec = Cursor::new(vec![header[12], header[13], header[14], header[15]]);
-            let mut addr = addr_vec.read_u32::<BigEndian>()?;
-            let mut count = 0;
-
-            while count < wcount {
-                let mut value_vec = Cursor::new(vec![
-                    buffer[(4 * count) as usize],
-                    buffer[(4 * count + 1) as usize],
-                    buffer[(4 * count + 2) as usize],
-                    buffer[(4 * count + 3) as usize],
-                ]);
-                let value = value_vec.read_u32::<BigEndian>()?;
-                bridge.poke(addr, value)?;
-                count += 1;
-                addr += 4;
+            let addr = BigEndian::read_u32(&record[4..8]);
+            payload.resize(wcount * 4, 0);
+            Self::read_exact(reader, payload)?;
+            if wcount == 1 {
+                bridge.poke(addr, BigEndian::read_u32(payload))?;
+            } else {
+                // Record writes land at incrementing addresses, which
+                // is exactly a burst.  The burst API carries words as
+                // little-endian bytes, so swap each word in place.
+                for value in payload.chunks_exact_mut(4) {
+                    value.reverse();
+                }
+                bridge.burst_write(addr, payload)?;
             }
-            Ok(())
-        } else if rcount > 0 {
-            // Read
-            let mut addr_vec = Cursor::new(vec![buffer[0], buffer[1], buffer[2], buffer[3]]);
-            let mut addr = addr_vec.read_u32::<BigEndian>()?;
-            let mut count = 0;
-            while count < rcount {
-                let value = bridge.peek(addr)?;
-                let mut value_vec = vec![];
-                value_vec.write_u32::<BigEndian>(value)?;
-
-                buffer[(count * 4) as usize] = value_vec[0];
-                buffer[(count * 4 + 1) as usize] = value_vec[1];
-                buffer[(count * 4 + 2) as usize] = value_vec[2];
-                buffer[(count * 4 + 3) as usize] = value_vec[3];
-
-                count += 1;
-                addr += 4;
+        }
+
+        if rcount > 0 {
+            // For a mixed record the base return address follows the
+            // write values; otherwise it was the first payload word.
+            let mut base_ret = [0; 4];
+            if wcount > 0 {
+                Self::read_exact(reader, &mut base_ret)?;
+            } else {
+                base_ret.copy_from_slice(&record[4..8]);
+            }
+
+            payload.resize(rcount * 4, 0);
+            Self::read_exact(reader, payload)?;
+
+            // The response mirrors the record as a write to the base
+            // return address.
+            let reply_offset = reply.len();
+            reply.push(record[0]);
+            reply.push(record[1]);
+            reply.push(rcount as u8);
+            reply.push(0);
+            reply.extend_from_slice(&base_ret);
+            reply.resize(reply_offset + 8 + rcount * 4, 0);
+
+            // Record addresses are arbitrary, but clients doing bulk
+            // transfers send contiguous ascending runs -- detect that
+            // and issue one burst instead of a transaction per word.
+            let first = BigEndian::read_u32(&payload[0..4]);
+            let contiguous = payload
+                .chunks_exact(4)
+                .enumerate()
+                .all(|(i, a)| BigEndian::read_u32(a) == first.wrapping_add(i as u32 * 4));
+            if rcount > 1 && contiguous {
+                bridge.burst_read_into(
+                    first,
+                    &mut reply[reply_offset + 8..reply_offset + 8 + rcount * 4],
+                )?;
+                // Burst data comes back as little-endian words; the
+                // wire wants big-endian.
+                for value in reply[reply_offset + 8..].chunks_exact_mut(4) {
+                    value.reverse();
+                }
+            } else {
+                for (i, addr) in payload.chunks_exact(4).enumerate() {
+                    let value = bridge.peek(BigEndian::read_u32(addr))?;
+                    let out = reply_offset + 8 + i * 4;
+                    BigEndian::write_u32(&mut reply[out..out + 4], value);
+                }
+            }
+        }
+
+        Ok(())
+    }
+
+    pub fn process(&mut self, bridge: &Bridge) -> Result<(), WishboneServerError> {
+        let mut reply = std::mem::replace(&mut self.reply, vec![]);
+        reply.clear();
+        let mut result = Ok(());
+
+        // One iteration per Etherbone packet.  The first header read
+        // blocks for the next request; after that, another packet is
+        // only started if the client has already pipelined more bytes,
+        // so the responses to a whole pipelined batch coalesce into the
+        // single send below.
+        'packets: loop {
+            let mut header = [0; 8];
+            if let Err(e) = Self::read_exact(&mut self.reader, &mut header) {
+                result = Err(e);
+                break;
             }
 
-            // Response goes back as a write
-            header[10] = header[11];
-            header[11] = 0;
-            connection.write_all(&header)?;
-            connection.write_all(&buffer)?;
-            Ok(())
-        } else {
-            Err(WishboneServerError::UnsupportedOperation)
+            // Validate signature matches
+            if header[0] != 0x4e || header[1] != 0x6f {
+                result = Err(WishboneServerError::NoMagic);
+                break;
+            }
+
+            // Remember where this packet's response begins, so a
+            // write-only packet (or a failed one) can be dropped from
+            // the batch without disturbing earlier responses.
+            let packet_start = reply.len();
+            reply.extend_from_slice(&header);
+
+            loop {
+                if let Err(e) = Self::process_record(
+                    &mut self.reader,
+                    bridge,
+                    &mut self.payload,
+                    &mut reply,
+                ) {
+                    reply.truncate(packet_start);
+                    result = Err(e);
+                    break 'packets;
+                }
+
+                // Etherbone-over-TCP carries no length field, so peek at
+                // whatever the reader has already buffered: more bytes that
+                // don't open a new packet (magic 0x4e 0x6f) are a further
+                // record in this packet.  An empty buffer means the packet
+                // is done -- never block waiting for a record that may not
+                // come.
+                let pending = self.reader.buffer();
+                if pending.is_empty() || pending[0] == 0x4e {
+                    break;
+                }
+            }
+
+            // Only reads generate a response; drop the echoed header of
+            // a write-only packet.
+            if reply.len() == packet_start + header.len() {
+                reply.truncate(packet_start);
+            }
+
+            if self.reader.buffer().is_empty() {
+                break;
+            }
+        }
+
+        // One syscall -- and, with TCP_NODELAY, one wire packet --
+        // covers every response accumulated above.  Flush even when a
+        // later packet failed, so responses already earned are not
+        // dropped along with the connection.
+        if !reply.is_empty() {
+            let flushed = self.connection.write_all(&reply);
+            if result.is_ok() {
+                result = flushed.map_err(|e| e.into());
+            }
         }
+        self.reply = reply;
+        result
     }
 }
@@ -1,6 +1,9 @@
 use std::marker::PhantomData;
 use std::mem;
 use std::ptr;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread::{self, JoinHandle};
 use std::time::Duration;
 
 use libc::{c_int, c_void, timeval};
@@ -182,6 +185,61 @@ impl Context {
     }
 }
 
+/// Raw context pointer that can be moved onto the event thread.
+struct ContextPtr(*mut libusb_context);
+unsafe impl Send for ContextPtr {}
+
+/// A dedicated event-handling thread, created with
+/// [`Context::event_pump()`](struct.Context.html#method.event_pump).
+///
+/// While this value is alive, a background thread sleeps in
+/// `libusb_handle_events_completed()` and services transfer completions,
+/// timeouts and hotplug callbacks for the whole context, so threads with
+/// transfers in flight do not need to poll for events themselves. The
+/// thread only wakes when the kernel reports activity (transfer timeouts
+/// are delivered through timerfd on Linux rather than by periodic
+/// polling). Dropping the value interrupts the handler and joins the
+/// thread.
+pub struct EventPump<'a> {
+    _context: PhantomData<&'a Context>,
+    raw: *mut libusb_context,
+    running: Arc<AtomicBool>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl<'a> Drop for EventPump<'a> {
+    fn drop(&mut self) {
+        self.running.store(false, Ordering::Relaxed);
+        unsafe { libusb_interrupt_event_handler(self.raw) };
+        if let Some(thread) = self.thread.take() {
+            thread.join().ok();
+        }
+    }
+}
+
+impl Context {
+    /// Spawns a dedicated thread that services `libusb` events for this
+    /// context until the returned [`EventPump`](struct.EventPump.html) is
+    /// dropped.
+    pub fn event_pump(&self) -> EventPump {
+        let running = Arc::new(AtomicBool::new(true));
+        let thread_running = running.clone();
+        let ptr = ContextPtr(self.context);
+        let thread = thread::spawn(move || {
+            let ptr = ptr;
+            while thread_running.load(Ordering::Relaxed) {
+                unsafe { libusb_handle_events_completed(ptr.0, std::ptr::null_mut()) };
+            }
+        });
+        EventPump {
+            _context: PhantomData,
+            raw: self.context,
+            running,
+            thread: Some(thread),
+        }
+    }
+}
+
 extern "C" fn hotplug_callback(
     _ctx: *mut libusb_context,
     device: *mut libusb_device,
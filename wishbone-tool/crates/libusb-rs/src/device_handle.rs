@@ -1,9 +1,11 @@
 use std::marker::PhantomData;
 use std::slice;
+use std::sync::atomic::{AtomicIsize, Ordering};
+use std::sync::Mutex;
 use std::time::Duration;
 
 use bit_set::BitSet;
-use libc::{c_int, c_uchar, c_uint};
+use libc::{c_int, c_uchar, c_uint, c_void};
 use libusb::*;
 
 use config_descriptor::ConfigDescriptor;
@@ -19,6 +21,10 @@ pub struct DeviceHandle<'a> {
     _context: PhantomData<&'a Context>,
     handle: *mut libusb_device_handle,
     interfaces: BitSet,
+
+    /// Pool of backing buffers reused by `read_control_batch`, so a
+    /// stream of batched transfers does not allocate per transfer.
+    scratch: Mutex<Vec<Vec<u8>>>,
 }
 
 impl<'a> Drop for DeviceHandle<'a> {
@@ -404,6 +410,306 @@ impl<'a> DeviceHandle<'a> {
         }
     }
 
+    /// Submits a batch of control read transfers and waits for all of
+    /// them to complete.
+    ///
+    /// Each entry in `chunks` supplies the `wValue` and `wIndex` setup fields and the buffer
+    /// the response is written into; `request_type` and `request` are shared by the whole
+    /// batch. All transfers are submitted before any completion is reaped, so the device can
+    /// work on the next transfer while the host processes the previous one, instead of paying
+    /// a full round trip per transfer as `read_control()` does.
+    ///
+    /// On success, returns the number of bytes received into each buffer, in order. If any
+    /// transfer fails, the first error is returned after every transfer has completed or been
+    /// cancelled.
+    pub fn read_control_batch(
+        &self,
+        context: &Context,
+        request_type: u8,
+        request: u8,
+        chunks: &mut [(u16, u16, &mut [u8])],
+        timeout: Duration,
+    ) -> ::Result<Vec<usize>> {
+        if request_type & LIBUSB_ENDPOINT_DIR_MASK != LIBUSB_ENDPOINT_IN {
+            return Err(Error::InvalidParam);
+        }
+        if chunks.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        let timeout_ms =
+            (timeout.as_secs() * 1000 + timeout.subsec_nanos() as u64 / 1_000_000) as c_uint;
+
+        // Completion callbacks run inside handle_events(), which may be
+        // this thread's reap loop below or a dedicated event thread
+        // (see Context::event_pump()); they only decrement the
+        // outstanding-transfer count, so an atomic is all the
+        // synchronization they need.
+        extern "C" fn batch_done(transfer: *mut libusb_transfer) {
+            unsafe {
+                let remaining = (*transfer).user_data as *const AtomicIsize;
+                (*remaining).fetch_sub(1, Ordering::AcqRel);
+            }
+        }
+
+        let remaining = AtomicIsize::new(chunks.len() as isize);
+
+        // A control transfer's buffer carries the 8-byte setup packet
+        // in front of the data. The backing buffers are drawn from a
+        // per-handle pool so steady-state batches do not allocate.
+        let mut buffers: Vec<Vec<u8>> = {
+            let mut pool = self.scratch.lock().unwrap();
+            chunks
+                .iter()
+                .map(|(value, index, buf)| {
+                    let mut backing = pool.pop().unwrap_or_default();
+                    backing.clear();
+                    backing.resize(8 + buf.len(), 0);
+                    backing[0] = request_type;
+                    backing[1] = request;
+                    backing[2..4].copy_from_slice(&value.to_le_bytes());
+                    backing[4..6].copy_from_slice(&index.to_le_bytes());
+                    backing[6..8].copy_from_slice(&(buf.len() as u16).to_le_bytes());
+                    backing
+                })
+                .collect()
+        };
+
+        let mut transfers: Vec<*mut libusb_transfer> = Vec::with_capacity(chunks.len());
+        for backing in buffers.iter_mut() {
+            let transfer = unsafe { libusb_alloc_transfer(0) };
+            if transfer.is_null() {
+                for transfer in transfers {
+                    unsafe { libusb_free_transfer(transfer) };
+                }
+                return Err(Error::NoMem);
+            }
+            unsafe {
+                (*transfer).dev_handle = self.handle;
+                (*transfer).flags = 0;
+                (*transfer).endpoint = 0;
+                (*transfer).transfer_type = LIBUSB_TRANSFER_TYPE_CONTROL;
+                (*transfer).timeout = timeout_ms;
+                (*transfer).length = backing.len() as c_int;
+                (*transfer).callback = batch_done;
+                (*transfer).user_data = &remaining as *const AtomicIsize as *mut c_void;
+                (*transfer).buffer = backing.as_mut_ptr();
+                (*transfer).num_iso_packets = 0;
+            }
+            transfers.push(transfer);
+        }
+
+        let mut first_error = None;
+        let mut submitted = 0;
+        for transfer in &transfers {
+            match unsafe { libusb_submit_transfer(*transfer) } {
+                0 => submitted += 1,
+                e => {
+                    first_error = Some(error::from_libusb(e));
+                    break;
+                }
+            }
+        }
+        // Transfers that never made it onto the bus will not call the
+        // completion callback.
+        remaining.fetch_sub((transfers.len() - submitted) as isize, Ordering::AcqRel);
+        if first_error.is_some() {
+            for transfer in &transfers[..submitted] {
+                unsafe { libusb_cancel_transfer(*transfer) };
+            }
+        }
+
+        // Reap completions until every submitted transfer has called
+        // back; the buffers must stay alive until then.
+        let mut cancelled = first_error.is_some();
+        while remaining.load(Ordering::Acquire) > 0 {
+            if context.handle_events(Some(Duration::from_millis(100))).is_err() && !cancelled {
+                for transfer in &transfers[..submitted] {
+                    unsafe { libusb_cancel_transfer(*transfer) };
+                }
+                cancelled = true;
+            }
+        }
+
+        let mut lengths = Vec::with_capacity(chunks.len());
+        for (i, transfer) in transfers.iter().enumerate() {
+            let (status, actual) =
+                unsafe { ((**transfer).status, (**transfer).actual_length as usize) };
+            if i < submitted && status == LIBUSB_TRANSFER_COMPLETED {
+                let data = &buffers[i][8..8 + actual.min(chunks[i].2.len())];
+                chunks[i].2[..data.len()].copy_from_slice(data);
+                lengths.push(data.len());
+            } else if first_error.is_none() {
+                first_error = Some(match status {
+                    LIBUSB_TRANSFER_TIMED_OUT => Error::Timeout,
+                    LIBUSB_TRANSFER_STALL => Error::Pipe,
+                    LIBUSB_TRANSFER_NO_DEVICE => Error::NoDevice,
+                    LIBUSB_TRANSFER_OVERFLOW => Error::Overflow,
+                    _ => Error::Io,
+                });
+            }
+            unsafe { libusb_free_transfer(*transfer) };
+        }
+
+        // Every transfer has completed or been freed, so the backing
+        // buffers can be recycled for the next batch.
+        self.scratch.lock().unwrap().append(&mut buffers);
+
+        match first_error {
+            Some(e) => Err(e),
+            None => Ok(lengths),
+        }
+    }
+
+    /// Submits a batch of control write transfers and waits for all of
+    /// them to complete.
+    ///
+    /// The write-direction counterpart of
+    /// [`read_control_batch()`](#method.read_control_batch): each entry in `chunks` supplies
+    /// the `wValue` and `wIndex` setup fields and the data to send, while `request_type` and
+    /// `request` are shared by the whole batch. All transfers are submitted through the async
+    /// core before any completion is reaped, so the fixed per-transfer cost of the synchronous
+    /// path (setup, event-loop wait, wakeup) is paid once per batch rather than once per
+    /// chunk.
+    ///
+    /// On success, returns the number of bytes sent for each chunk, in order. If any transfer
+    /// fails, the first error is returned after every transfer has completed or been
+    /// cancelled.
+    pub fn write_control_batch(
+        &self,
+        context: &Context,
+        request_type: u8,
+        request: u8,
+        chunks: &[(u16, u16, &[u8])],
+        timeout: Duration,
+    ) -> ::Result<Vec<usize>> {
+        if request_type & LIBUSB_ENDPOINT_DIR_MASK != LIBUSB_ENDPOINT_OUT {
+            return Err(Error::InvalidParam);
+        }
+        if chunks.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        let timeout_ms =
+            (timeout.as_secs() * 1000 + timeout.subsec_nanos() as u64 / 1_000_000) as c_uint;
+
+        // See read_control_batch(): completions may fire on any thread
+        // that is pumping events, so the count is atomic.
+        extern "C" fn batch_done(transfer: *mut libusb_transfer) {
+            unsafe {
+                let remaining = (*transfer).user_data as *const AtomicIsize;
+                (*remaining).fetch_sub(1, Ordering::AcqRel);
+            }
+        }
+
+        let remaining = AtomicIsize::new(chunks.len() as isize);
+
+        // A control transfer's buffer carries the 8-byte setup packet
+        // in front of the data. The backing buffers are drawn from a
+        // per-handle pool so steady-state batches do not allocate.
+        let mut buffers: Vec<Vec<u8>> = {
+            let mut pool = self.scratch.lock().unwrap();
+            chunks
+                .iter()
+                .map(|(value, index, buf)| {
+                    let mut backing = pool.pop().unwrap_or_default();
+                    backing.clear();
+                    backing.resize(8 + buf.len(), 0);
+                    backing[0] = request_type;
+                    backing[1] = request;
+                    backing[2..4].copy_from_slice(&value.to_le_bytes());
+                    backing[4..6].copy_from_slice(&index.to_le_bytes());
+                    backing[6..8].copy_from_slice(&(buf.len() as u16).to_le_bytes());
+                    backing[8..].copy_from_slice(buf);
+                    backing
+                })
+                .collect()
+        };
+
+        let mut transfers: Vec<*mut libusb_transfer> = Vec::with_capacity(chunks.len());
+        for backing in buffers.iter_mut() {
+            let transfer = unsafe { libusb_alloc_transfer(0) };
+            if transfer.is_null() {
+                for transfer in transfers {
+                    unsafe { libusb_free_transfer(transfer) };
+                }
+                return Err(Error::NoMem);
+            }
+            unsafe {
+                (*transfer).dev_handle = self.handle;
+                (*transfer).flags = 0;
+                (*transfer).endpoint = 0;
+                (*transfer).transfer_type = LIBUSB_TRANSFER_TYPE_CONTROL;
+                (*transfer).timeout = timeout_ms;
+                (*transfer).length = backing.len() as c_int;
+                (*transfer).callback = batch_done;
+                (*transfer).user_data = &remaining as *const AtomicIsize as *mut c_void;
+                (*transfer).buffer = backing.as_mut_ptr();
+                (*transfer).num_iso_packets = 0;
+            }
+            transfers.push(transfer);
+        }
+
+        let mut first_error = None;
+        let mut submitted = 0;
+        for transfer in &transfers {
+            match unsafe { libusb_submit_transfer(*transfer) } {
+                0 => submitted += 1,
+                e => {
+                    first_error = Some(error::from_libusb(e));
+                    break;
+                }
+            }
+        }
+        // Transfers that never made it onto the bus will not call the
+        // completion callback.
+        remaining.fetch_sub((transfers.len() - submitted) as isize, Ordering::AcqRel);
+        if first_error.is_some() {
+            for transfer in &transfers[..submitted] {
+                unsafe { libusb_cancel_transfer(*transfer) };
+            }
+        }
+
+        // Reap completions until every submitted transfer has called
+        // back; the buffers must stay alive until then.
+        let mut cancelled = first_error.is_some();
+        while remaining.load(Ordering::Acquire) > 0 {
+            if context.handle_events(Some(Duration::from_millis(100))).is_err() && !cancelled {
+                for transfer in &transfers[..submitted] {
+                    unsafe { libusb_cancel_transfer(*transfer) };
+                }
+                cancelled = true;
+            }
+        }
+
+        let mut lengths = Vec::with_capacity(chunks.len());
+        for (i, transfer) in transfers.iter().enumerate() {
+            let (status, actual) =
+                unsafe { ((**transfer).status, (**transfer).actual_length as usize) };
+            if i < submitted && status == LIBUSB_TRANSFER_COMPLETED {
+                lengths.push(actual.min(chunks[i].2.len()));
+            } else if first_error.is_none() {
+                first_error = Some(match status {
+                    LIBUSB_TRANSFER_TIMED_OUT => Error::Timeout,
+                    LIBUSB_TRANSFER_STALL => Error::Pipe,
+                    LIBUSB_TRANSFER_NO_DEVICE => Error::NoDevice,
+                    LIBUSB_TRANSFER_OVERFLOW => Error::Overflow,
+                    _ => Error::Io,
+                });
+            }
+            unsafe { libusb_free_transfer(*transfer) };
+        }
+
+        // Every transfer has completed or been freed, so the backing
+        // buffers can be recycled for the next batch.
+        self.scratch.lock().unwrap().append(&mut buffers);
+
+        match first_error {
+            Some(e) => Err(e),
+            None => Ok(lengths),
+        }
+    }
+
     /// Writes data using a control transfer.
     ///
     /// This function attempts to write the contents of `buf` to the device using a control
@@ -601,6 +907,55 @@ impl<'a> DeviceHandle<'a> {
             Some(n) => self.read_string_descriptor(language, n, timeout),
         }
     }
+
+    /// Allocates `len` bytes of zero-copy transfer memory for this device.
+    ///
+    /// On Linux the buffer is mmap'd from usbfs, so bulk transfers using it
+    /// avoid the kernel↔user copy on every URB. Returns
+    /// `Err(Error::NotSupported)` when the platform or kernel cannot provide
+    /// device memory; callers should fall back to an ordinary heap buffer.
+    pub fn dev_mem_alloc(&'a self, len: usize) -> ::Result<DeviceMemory<'a>> {
+        let ptr = unsafe { libusb_dev_mem_alloc(self.handle, len) };
+        if ptr.is_null() {
+            Err(Error::NotSupported)
+        } else {
+            Ok(DeviceMemory {
+                handle: self,
+                ptr,
+                len,
+            })
+        }
+    }
+}
+
+/// Zero-copy transfer memory allocated from the device's usbfs mapping.
+///
+/// Dereferences to a byte slice suitable for passing as a transfer buffer;
+/// the mapping is released when the value is dropped.
+pub struct DeviceMemory<'a> {
+    handle: &'a DeviceHandle<'a>,
+    ptr: *mut c_uchar,
+    len: usize,
+}
+
+impl<'a> Drop for DeviceMemory<'a> {
+    fn drop(&mut self) {
+        unsafe { libusb_dev_mem_free(self.handle.handle, self.ptr, self.len) };
+    }
+}
+
+impl<'a> std::ops::Deref for DeviceMemory<'a> {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        unsafe { slice::from_raw_parts(self.ptr, self.len) }
+    }
+}
+
+impl<'a> std::ops::DerefMut for DeviceMemory<'a> {
+    fn deref_mut(&mut self) -> &mut [u8] {
+        unsafe { slice::from_raw_parts_mut(self.ptr, self.len) }
+    }
 }
 
 #[doc(hidden)]
@@ -612,5 +967,6 @@ pub unsafe fn from_libusb<'a>(
         _context: context,
         handle,
         interfaces: BitSet::with_capacity(u8::max_value() as usize + 1),
+        scratch: Mutex::new(Vec::new()),
     }
 }
@@ -7,9 +7,9 @@ extern crate libusb_sys_wishbone_tool as libusb;
 pub use error::{Error, Result};
 pub use version::{version, LibraryVersion};
 
-pub use context::{Context, Hotplug, LogLevel, Registration};
+pub use context::{Context, EventPump, Hotplug, LogLevel, Registration};
 pub use device::Device;
-pub use device_handle::DeviceHandle;
+pub use device_handle::{DeviceHandle, DeviceMemory};
 pub use device_list::{DeviceList, Devices};
 
 pub use config_descriptor::{ConfigDescriptor, Interfaces};